@@ -0,0 +1,389 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "deb822.h"
+#include "mapped_file.h"
+#include "relation.h"
+
+using namespace DEBAR;
+
+namespace {
+
+// Every pass is timed and the fastest one is kept, a cold page cache or a
+// busy machine should not count against either side.
+const int PASSES = 20;
+
+/**
+ * @brief What a parser saw, both sides must agree or the timing is moot.
+ */
+struct Totals
+{
+    size_t fields = 0;
+    size_t bytes = 0;
+
+    bool operator!=(const Totals& other) const
+    {
+        return fields != other.fields || bytes != other.bytes;
+    }
+};
+
+template <typename Func>
+double best_seconds(Func func, Totals& totals)
+{
+    double best = 0;
+    for (int i = 0; i < PASSES; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        totals = func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+void report(const char* name, size_t size, double seconds, double baseline)
+{
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << size / seconds / 1e6 << " MB/s";
+    if (baseline > 0) std::cout << std::setprecision(2) << std::setw(8) << baseline / seconds << "x";
+    std::cout << std::endl;
+}
+
+/**
+ * @brief Walk every field of the mapped file with Deb822Parser and
+ *        Deb822Stanza, the way `--update` reads a Packages file.
+ */
+Totals parse_deb822(std::string_view text)
+{
+    Totals totals;
+    Deb822Parser parser(text);
+    std::string_view stanza;
+    while (parser.next(stanza)) {
+        Deb822Stanza reader(stanza);
+        Deb822Field field;
+        while (reader.next(field)) {
+            totals.fields++;
+            totals.bytes += field.value.size();
+        }
+    }
+    return totals;
+}
+
+/**
+ * @brief The line by line reading used before Deb822Parser, std::getline
+ *        into a string and substr for the name and the value.
+ *
+ * Folded values are joined with their newlines so the totals match.
+ */
+Totals parse_getline(const std::string& path)
+{
+    Totals totals;
+    std::ifstream file(path, std::ios::in);
+    std::string line;
+    std::string name;
+    std::string value;
+    bool inField = false;
+    auto flush = [&]() {
+        if (!inField) return;
+        totals.fields++;
+        totals.bytes += value.size();
+        inField = false;
+    };
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            flush();
+            continue;
+        }
+        if (line[0] == ' ' || line[0] == '\t') {
+            if (inField) value += "\n" + line;
+            continue;
+        }
+        flush();
+        if (line[0] == '#') continue;
+        auto colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        name = line.substr(0, colon);
+        auto begin = line.find_first_not_of(" \t", colon + 1);
+        value = begin == std::string::npos ? std::string() : line.substr(begin);
+        inField = true;
+    }
+    flush();
+    return totals;
+}
+
+/**
+ * @brief Collect the relationship fields debar resolves.
+ */
+std::vector<std::string_view> relation_values(std::string_view text)
+{
+    std::vector<std::string_view> values;
+    Deb822Parser parser(text);
+    std::string_view stanza;
+    while (parser.next(stanza)) {
+        Deb822Stanza reader(stanza);
+        Deb822Field field;
+        while (reader.next(field)) {
+            if (field.name == "Depends" || field.name == "Pre-Depends" || field.name == "Suggests") {
+                values.push_back(field.value);
+            }
+        }
+    }
+    return values;
+}
+
+// The tokenizer RelationParser replaced, kept here only to time against.
+
+std::vector<std::string> split_str(const std::string &str, const std::string &split)
+{
+    std::vector<std::string> result;
+    size_t start = 0;
+    size_t end = str.find(split);
+    while (end != std::string::npos) {
+        result.push_back(str.substr(start, end - start));
+        start = end + split.length();
+        end = str.find(split, start);
+    }
+    result.push_back(str.substr(start, end));
+    return result;
+}
+
+struct PackageName {
+    std::string name;
+    std::string version;
+};
+
+typedef std::vector<PackageName> PackageItem;
+
+PackageItem parsePackageItem(const std::string& item) {
+    auto packages = split_str(item, " | ");
+    PackageItem res;
+    for (auto pkg : packages)
+    {
+        auto tmp = split_str(pkg, " (");
+        PackageName name;
+        name.name = tmp[0];
+        if (name.name.find(":any") != std::string::npos)
+        {
+            name.name = name.name.substr(0, name.name.size() - 4);
+        }
+
+        if (tmp.size() > 1)
+        {
+            name.version = tmp[1].substr(0, tmp[1].size() - 1);
+        }
+        res.push_back(name);
+    }
+    return res;
+}
+
+Totals parse_split_str(const std::vector<std::string>& values)
+{
+    Totals totals;
+    for (const auto& value : values) {
+        for (const auto& item : split_str(value, ", ")) {
+            for (const auto& package : parsePackageItem(item)) {
+                totals.fields++;
+                totals.bytes += package.name.size();
+            }
+        }
+    }
+    return totals;
+}
+
+Totals parse_relation_parser(const std::vector<std::string_view>& values)
+{
+    Totals totals;
+    for (auto value : values) {
+        RelationParser parser(value);
+        Relation relation;
+        while (parser.next(relation)) {
+            totals.fields++;
+            totals.bytes += relation.name.size();
+        }
+    }
+    return totals;
+}
+
+// Two ways to find the end of a package name, RelationParser uses the
+// second where SSE2 is available. Both stop at whitespace or one of
+// `,|([<:`.
+
+bool is_delimiter(char c)
+{
+    switch (c) {
+    case ' ': case '\t': case '\r': case '\n':
+    case ',': case '|': case '(': case '[': case '<': case ':':
+        return true;
+    default:
+        return false;
+    }
+}
+
+struct DelimiterTable
+{
+    bool table[256] = {};
+
+    DelimiterTable()
+    {
+        for (int c = 0; c < 256; c++) table[c] = is_delimiter(static_cast<char>(c));
+    }
+};
+
+const DelimiterTable DELIMITERS;
+
+const char* scan_table(const char* p, const char* end)
+{
+    while (p < end && !DELIMITERS.table[static_cast<unsigned char>(*p)]) p++;
+    return p;
+}
+
+#ifdef __SSE2__
+/**
+ * @brief Compare 16 bytes at a time against every delimiter, the tail
+ *        falls back to the table.
+ */
+const char* scan_sse2(const char* p, const char* end)
+{
+    static const char delimiters[] = " \t\r\n,|([<:";
+    __m128i needles[sizeof(delimiters) - 1];
+    for (size_t i = 0; i < sizeof(needles) / sizeof(needles[0]); i++) needles[i] = _mm_set1_epi8(delimiters[i]);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_setzero_si128();
+        for (const auto& needle : needles) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needle));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return scan_table(p, end);
+}
+#endif
+
+/**
+ * @brief The name and architecture scan of RelationParser::next() with a
+ *        pluggable delimiter search, everything else is the same.
+ */
+template <const char* (*Scan)(const char*, const char*)>
+Totals parse_with_scan(const std::vector<std::string_view>& values)
+{
+    Totals totals;
+    for (auto value : values) {
+        const char* p = value.data();
+        const char* end = p + value.size();
+        while (true) {
+            while (p < end && (*p == ',' || *p == '|' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+            if (p == end) break;
+            const char* begin = p;
+            p = Scan(p, end);
+            totals.fields++;
+            totals.bytes += p - begin;
+            if (p < end && *p == ':') p = Scan(p + 1, end);
+            while (p < end) {
+                if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+                    p++;
+                    continue;
+                }
+                char close;
+                if (*p == '(') close = ')';
+                else if (*p == '[') close = ']';
+                else if (*p == '<') close = '>';
+                else break;
+                auto found = static_cast<const char*>(std::memchr(p + 1, close, end - p - 1));
+                p = found ? found + 1 : end;
+            }
+        }
+    }
+    return totals;
+}
+
+bool check(const char* name, const Totals& totals, const Totals& expected)
+{
+    if (totals != expected) {
+        std::cerr << name << " disagrees: " << totals.fields << " relations, " << totals.bytes << " bytes vs "
+                  << expected.fields << " relations, " << expected.bytes << " bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Time the relationship tokenizers over every Depends, Pre-Depends
+ *        and Suggests value of the file.
+ */
+bool bench_relations(std::string_view text)
+{
+    auto values = relation_values(text);
+    std::vector<std::string> copies(values.begin(), values.end());
+    size_t size = 0;
+    for (auto value : values) size += value.size();
+    std::cout << std::endl << values.size() << " relationship fields, " << size << " bytes" << std::endl;
+
+    Totals old;
+    Totals parser;
+    Totals table;
+    double oldSeconds = best_seconds([&]() { return parse_split_str(copies); }, old);
+    double parserSeconds = best_seconds([&]() { return parse_relation_parser(values); }, parser);
+    double tableSeconds = best_seconds([&]() { return parse_with_scan<scan_table>(values); }, table);
+    if (!check("table scan", table, parser)) return false;
+    // The old tokenizer keeps architecture qualifiers other than `:any` in
+    // the name, only the number of relations must match.
+    if (old.fields != parser.fields) {
+        std::cerr << "split_str disagrees: " << old.fields << " relations vs " << parser.fields << std::endl;
+        return false;
+    }
+    std::cout << parser.fields << " relations" << std::endl;
+    report("split_str", size, oldSeconds, 0);
+    report("RelationParser", size, parserSeconds, oldSeconds);
+    report("name scan: table", size, tableSeconds, tableSeconds);
+#ifdef __SSE2__
+    Totals sse2;
+    double sse2Seconds = best_seconds([&]() { return parse_with_scan<scan_sse2>(values); }, sse2);
+    if (!check("SSE2 scan", sse2, parser)) return false;
+    report("name scan: SSE2", size, sse2Seconds, tableSeconds);
+#endif
+    return true;
+}
+
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <Packages file>" << std::endl;
+        return -1;
+    }
+
+    std::string path = argv[1];
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return -1;
+    }
+    std::string_view text(file.data(), file.size());
+    std::cout << path << ": " << file.size() << " bytes, best of " << PASSES << " passes" << std::endl;
+
+    Totals deb822;
+    Totals getline;
+    double deb822Seconds = best_seconds([&]() { return parse_deb822(text); }, deb822);
+    double getlineSeconds = best_seconds([&]() { return parse_getline(path); }, getline);
+    if (deb822 != getline) {
+        std::cerr << "Parsers disagree: " << deb822.fields << " fields, " << deb822.bytes << " bytes vs "
+                  << getline.fields << " fields, " << getline.bytes << " bytes" << std::endl;
+        return -1;
+    }
+    std::cout << deb822.fields << " fields" << std::endl;
+    report("getline + substr", file.size(), getlineSeconds, 0);
+    report("Deb822Parser", file.size(), deb822Seconds, getlineSeconds);
+
+    if (!bench_relations(text)) return -1;
+    return 0;
+}
@@ -2,12 +2,27 @@
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
 #include <yaml-cpp/yaml.h>
 #include <curl/curl.h>
-#include <zlib.h>
 #include <string.h>
 
 #include "cmd.h"
+#include "deb822.h"
+#include "decoder.h"
+#include "description_index.h"
+#include "downloader.h"
+#include "hash.h"
+#include "index.h"
+#include "mapped_file.h"
+#include "package_db.h"
+#include "package_field.h"
+#include "pdiff.h"
+#include "relation.h"
+#include "release.h"
+#include "resolver.h"
+#include "stanza_scanner.h"
+#include "trigram_index.h"
 #include "utils.h"
 
 using namespace DEBAR;
@@ -21,14 +36,19 @@ struct DEBAR::CachePrivate
 {
     std::string path = ".";
     std::string repo_url = "";
+    std::vector<std::string> mirrors;
     std::string arch = "";
     std::string release_name = "";
     std::vector<std::string> components;
+    size_t parallel = 4;
+    std::string store;
 
-    std::map<std::string, PackageInfoPtr> already_found;
+    Index index;
+    PackageDB db;
+    TrigramIndex trigram;
+    DescriptionIndex description;
     std::set<std::string> already_not_found;
     std::set<std::string> exclude;
-    std::map<std::string, PackageInfoPtr> already_download;
 };
 
 Cache *DEBAR::Cache::instance()
@@ -57,6 +77,7 @@ bool DEBAR::Cache::init_work_directory()
     config["repo"]["components"].push_back("multiverse");
     config["repo"]["arch"] = "amd64";
     config["repo"]["release_name"] = "focal";
+    config["download"]["parallel"] = 4;
 
     std::ofstream configFile("config.yaml", std::ios::out);
     configFile << config;
@@ -75,6 +96,22 @@ bool DEBAR::Cache::load_work_directory()
         CACHE_INS->d->components = config["repo"]["components"].as<std::vector<std::string>>();
         CACHE_INS->d->arch = config["repo"]["arch"].as<std::string>();
         CACHE_INS->d->release_name = config["repo"]["release_name"].as<std::string>();
+        CACHE_INS->d->mirrors = {CACHE_INS->d->repo_url};
+        if (config["repo"]["mirrors"].IsDefined())
+        {
+            for (const auto& mirror : config["repo"]["mirrors"].as<std::vector<std::string>>())
+            {
+                CACHE_INS->d->mirrors.push_back(mirror);
+            }
+        }
+        if (config["download"]["parallel"].IsDefined())
+        {
+            CACHE_INS->d->parallel = config["download"]["parallel"].as<size_t>();
+        }
+        if (config["download"]["store"].IsDefined())
+        {
+            CACHE_INS->d->store = config["download"]["store"].as<std::string>();
+        }
         if (config["exclude"].IsDefined())
         {
             auto exclude = config["exclude"].as<std::vector<std::string>>();
@@ -93,334 +130,811 @@ bool DEBAR::Cache::load_work_directory()
     return true;
 }
 
-bool DEBAR::Cache::update_cache()
+/**
+ * @brief Append the packages of a relationship field with their version
+ *        constraints, the first of each group of alternatives.
+ */
+void parse_relations(std::string_view value, std::vector<Dependency>& dependencies)
 {
-    std::cout << "Downloading Cache files..." << std::endl;
-    std::ofstream indexFile(CACHE_INS->d->path + "/.debar/index", std::ios::out | std::ios::binary);
+    RelationParser parser(value);
+    Relation relation;
+    while (parser.next(relation)) {
+        if (relation.alternative || relation.name.empty()) continue;
+        Dependency dep;
+        dep.name = relation.name;
+        dep.op = parse_version_op(relation.op);
+        if (dep.op != VersionOp::Any) dep.version = relation.version;
+        dependencies.push_back(std::move(dep));
+    }
+}
 
-    for (int i = 0; i < CACHE_INS->d->components.size(); i++)
-    {
-        auto component = CACHE_INS->d->components[i];
-        std::string url = CACHE_INS->d->repo_url + "dists/" + CACHE_INS->d->release_name + "/" + component + "/binary-" + CACHE_INS->d->arch + "/Packages.gz";
-        std::string text = "Downloading " + component + " Packages.gz";
-        auto packageZipFile = CACHE_INS->d->path + "/.debar/" + component + ".Packages.gz";
-        if (!Utils::download_file(url, packageZipFile, text.c_str())) {
-            std::cerr << "Failed to download file: " << url << std::endl;
-            return false;
-        }
-        if (!unzip_gz_file(packageZipFile)) {
-            std::cerr << "Failed to unzip file: " << packageZipFile << std::endl;
-            return false;
-        }
-        auto packageFile = packageZipFile.substr(0, packageZipFile.find_last_of('.'));
-        std::ifstream packageFileStream(packageFile, std::ios::in);
-        if (!packageFileStream) {
-            std::cerr << "Failed to open file: " << packageFile << std::endl;
-            indexFile.close();
-            return false;
-        }
-        std::string line;
-        std::string packageName;
-        std::streamoff pos_num = 0;
-        while (std::getline(packageFileStream, line)) {
-            if (line.find("Package: ") == 0) {
-                packageName = line.substr(9);
-                char name[128];
-                memset(name, 0, 128);
-                memcpy(name, packageName.c_str(), packageName.size());
-                indexFile.write(name, 128); 
-                memset(name, 0, 128);
-                memcpy(name, component.c_str(), component.size());
-                indexFile.write(name, 128);
-                indexFile.write((char*)&pos_num, sizeof(std::streamoff));
-            }
-            pos_num = static_cast<std::streamoff>(packageFileStream.tellg());
+/**
+ * @brief Parse a Packages stanza.
+ * @param stanza The stanza text.
+ */
+PackageRecord parse_stanza(std::string_view stanza)
+{
+    PackageRecord record;
+    Deb822Stanza reader(stanza);
+    Deb822Field field;
+    while (reader.next(field)) {
+        switch (package_field(field.name)) {
+        case PackageField::Package:
+            record.name = field.value;
+            break;
+        case PackageField::Version:
+            record.version = field.value;
+            break;
+        case PackageField::Filename:
+            record.filename = field.value;
+            break;
+        case PackageField::Size:
+            record.size = strtoull(std::string(field.value).c_str(), nullptr, 10);
+            break;
+        case PackageField::MD5sum:
+            record.md5 = field.value;
+            break;
+        case PackageField::SHA256:
+            record.sha256 = field.value;
+            break;
+        case PackageField::Depends:
+        case PackageField::PreDepends:
+            // Pre-Depends only adds an ordering constraint, both must be downloaded.
+            parse_relations(field.value, record.depends);
+            break;
+        case PackageField::Suggests:
+            parse_relations(field.value, record.suggests);
+            break;
+        case PackageField::Description:
+            record.description = field.line();
+            record.long_description = Deb822Stanza::unfold(field.folded());
+            break;
+        case PackageField::InstalledSize:
+        case PackageField::Recommends:
+        case PackageField::Provides:
+        case PackageField::Unknown:
+            break;
         }
     }
-    indexFile.flush();
-    indexFile.close();
+    return record;
+}
 
-    std::cout << "Update Cache successfully." << std::endl;
+/**
+ * @brief Parse a plain Packages file in place, the mapped file is never copied.
+ * @param path The path of Packages file.
+ * @param records Receives the records in file order.
+ * @return true if the file could be read.
+ */
+bool parse_packages_file(const std::string& path, std::vector<PackageRecord>& records)
+{
+    MappedFile file;
+    if (!file.open(path)) return false;
+    Deb822Parser parser(std::string_view(file.data(), file.size()));
+    std::string_view stanza;
+    while (parser.next(stanza)) {
+        records.push_back(parse_stanza(stanza));
+    }
     return true;
 }
 
-void get_all_package_depends(PackageInfoPtr package, std::vector<PackageInfoPtr> &data, int level = 0)
+bool download_text(const std::string& url, const std::string& label, std::string& text, DownloadTask task = DownloadTask())
+{
+    text.clear();
+    Downloader downloader(1);
+    task.url = url;
+    task.label = label;
+    task.sink = [&text](const char* data, size_t size) {
+        text.append(data, size);
+        return true;
+    };
+    task.quiet = true;
+    DownloadResponse response;
+    if (!task.response) task.response = &response;
+    downloader.add(task);
+    downloader.run();
+    return task.response->complete;
+}
+
+/**
+ * @brief Pick the smallest Packages file the Release lists in a supported format.
+ * @return The file extension, ".gz" if the Release does not list any.
+ */
+std::string choose_packages_extension(const Release& release, const std::string& base)
 {
-    static std::map<std::string, PackageInfoPtr> printed; 
-    if (level == 0)
+    std::string best = ".gz";
+    uint64_t bestSize = UINT64_MAX;
+    for (const auto& extension : Decoder::supported_extensions())
     {
-        printed.clear();
-    }
-    printed.insert(std::pair<std::string, PackageInfoPtr>(package->name, package));
-    data.push_back(package);
-    for (auto dep : package->depends) {
-        if (!dep)
-            continue;
-        if (printed.find(dep->name) == printed.end())
-        get_all_package_depends(dep, data, level + 1);
+        auto entry = release.find(base + extension);
+        if (entry && entry->size < bestSize) {
+            best = extension;
+            bestSize = entry->size;
+        }
     }
-    if (CMD::is_suggests())
+    return best;
+}
+
+/**
+ * @brief Validators of a downloaded file, kept to skip it next time.
+ */
+struct FileState
+{
+    std::string url;
+    std::string sha256;
+    std::string etag;
+    int64_t last_modified = 0;
+};
+
+/**
+ * @brief What the last successful update fetched, saved in `.debar/state.yaml`.
+ */
+struct UpdateState
+{
+    FileState release;
+    std::vector<std::pair<std::string, FileState>> components;
+};
+
+void file_state_to_yaml(const FileState& state, YAML::Node node)
+{
+    node["url"] = state.url;
+    node["sha256"] = state.sha256;
+    node["etag"] = state.etag;
+    node["last_modified"] = state.last_modified;
+}
+
+FileState file_state_from_yaml(const YAML::Node& node)
+{
+    FileState state;
+    state.url = node["url"].as<std::string>("");
+    state.sha256 = node["sha256"].as<std::string>("");
+    state.etag = node["etag"].as<std::string>("");
+    state.last_modified = node["last_modified"].as<int64_t>(0);
+    return state;
+}
+
+UpdateState load_update_state(const std::string& path)
+{
+    UpdateState state;
+    if (!fs::exists(path)) return state;
+    try
     {
-        for (auto dep : package->suggests) {
-            if (!dep)
-                continue;
-            if (printed.find(dep->name) == printed.end())
-            get_all_package_depends(dep, data, level + 1);
+        YAML::Node node = YAML::LoadFile(path);
+        state.release = file_state_from_yaml(node["release"]);
+        for (const auto& component : node["components"])
+        {
+            state.components.emplace_back(component["name"].as<std::string>(), file_state_from_yaml(component));
         }
     }
+    catch(const YAML::Exception& e)
+    {
+        // A broken state file only costs a full update.
+        return UpdateState();
+    }
+    return state;
 }
 
-bool DEBAR::Cache::download_package(const std::string &name)
+bool save_update_state(const std::string& path, const UpdateState& state)
 {
-    auto package = find_package(name);
-    CACHE_INS->d->already_download.clear();
-    std::cout << "You want to download package: \n" << std::endl;
-    std::cout << "\t" << package->name << " (" << package->version << ")\n" << std::endl;
-    std::cout << "This package has the following dependencies: \n" << std::endl;
-    std::vector<PackageInfoPtr> depends;
-    get_all_package_depends(package, depends);
-    std::cout << "\t";
-    size_t size = package->size;
-    for (int i = 0; i < depends.size(); i++)
+    YAML::Node node;
+    file_state_to_yaml(state.release, node["release"]);
+    for (const auto& component : state.components)
     {
-        std::string text = depends[i]->name + " (" + depends[i]->version + ")";
-        size += depends[i]->size;
-        std::cout << text << "   ";
+        YAML::Node item;
+        item["name"] = component.first;
+        file_state_to_yaml(component.second, item);
+        node["components"].push_back(item);
     }
-    
-    std::cout << "\n" << std::endl;
-    std::cout << "All " << depends.size() + 1 << " packages, Total size " << Utils::format_size(size) << ".\n" << std::endl;
-    __download_package(package);
-    std::cout << "All packages are downloaded." << std::endl;
-
-
+    std::ofstream file(path + ".tmp", std::ios::out | std::ios::trunc);
+    file << node;
+    file.close();
+    if (!file) return false;
+    fs::rename(path + ".tmp", path);
     return true;
 }
 
+/**
+ * @brief State of one component while its Packages file streams in.
+ */
+struct ComponentUpdate
+{
+    std::string name;
+    std::string path;
+    std::string extension;
+    FileState state;
+    bool reusable = false;
+    bool unchanged = false;
+    bool patched = false;
+    std::unique_ptr<PDiff> pdiff;
+    DownloadResponse response;
+    std::ofstream file;
+    std::unique_ptr<Decoder> decoder;
+    std::unique_ptr<StanzaScanner> scanner;
+    std::vector<PackageRecord> records;
+};
 
-bool DEBAR::Cache::__download_package(PackageInfoPtr package)
+bool DEBAR::Cache::update_cache()
 {
-    if (CACHE_INS->d->already_download.find(package->name) != CACHE_INS->d->already_download.end()) return true;
-    std::string url = CACHE_INS->d->repo_url + "/" + package->filename;
-    std::string text = "Downloading: " + package->name + " (" + package->version + ")";
-    std::string dir = CACHE_INS->d->path + "/packages";
-    if (!fs::exists(dir)) {
-        fs::create_directory(dir);
-    }
-    Utils::download_file(url, dir + package->filename.substr(package->filename.find_last_of("/")), text.c_str());
-    CACHE_INS->d->already_download.insert(std::pair<std::string, PackageInfoPtr>(package->name, package));
+    std::cout << "Downloading Cache files..." << std::endl;
 
-    for (auto dep : package->depends)
+    auto debarDir = CACHE_INS->d->path + "/.debar/";
+    auto statePath = debarDir + "state.yaml";
+    UpdateState oldState = load_update_state(statePath);
+    UpdateState newState;
+
+    // Release changes whenever any index changes, a conditional request
+    // on it alone answers a no-op update.
+    Release release;
+    std::string distsUrl = CACHE_INS->d->repo_url + "dists/" + CACHE_INS->d->release_name + "/";
+    auto releasePath = debarDir + "Release";
+    std::string releaseText;
+    bool releaseUnchanged = false;
+    for (const auto& name : {"InRelease", "Release"})
     {
-        __download_package(dep);
+        DownloadTask task;
+        DownloadResponse response;
+        task.response = &response;
+        if (oldState.release.url == distsUrl + name && fs::exists(releasePath)) {
+            task.if_none_match = oldState.release.etag;
+            task.if_modified_since = oldState.release.last_modified;
+        }
+        if (!download_text(distsUrl + name, std::string("Downloading ") + name, releaseText, task)) continue;
+
+        if (response.not_modified) {
+            std::ifstream file(releasePath, std::ios::in | std::ios::binary);
+            releaseText.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            releaseUnchanged = true;
+        }
+        if (!release.parse(releaseText)) continue;
+
+        newState.release = FileState{distsUrl + name, "", response.etag, response.last_modified};
+        if (response.not_modified) newState.release = oldState.release;
+        break;
+    }
+    if (newState.release.url.empty()) {
+        std::cerr << "No Release file found, assuming Packages.gz." << std::endl;
+    } else if (!releaseUnchanged) {
+        std::ofstream file(releasePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(releaseText.data(), releaseText.size());
     }
-    if (CMD::is_suggests())
+
+    // Downloaded bytes go through the decoder into the Packages file and
+    // the stanza scanner in one pass, nothing is read back from disk.
+    Downloader downloader(CACHE_INS->d->parallel);
+    auto download = [&](ComponentUpdate* update) {
+        update->file.open(update->path + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!update->file) {
+            std::cerr << "Failed to create file: " << update->path << ".tmp" << std::endl;
+            return false;
+        }
+        update->scanner.reset(new StanzaScanner([update](std::string_view stanza) {
+            update->records.push_back(parse_stanza(stanza));
+        }));
+        update->decoder = Decoder::create(update->extension, [update](const char* data, size_t size) {
+            update->file.write(data, size);
+            update->scanner->write(data, size);
+            return static_cast<bool>(update->file);
+        });
+
+        DownloadTask task;
+        task.url = update->state.url;
+        task.label = "Downloading " + update->name + " Packages" + update->extension;
+        task.sink = [update](const char* data, size_t size) {
+            return update->decoder->write(data, size);
+        };
+        task.response = &update->response;
+        // Without a Release checksum, ask the server whether it changed.
+        if (update->reusable && update->state.sha256.empty()) {
+            task.if_none_match = update->state.etag;
+            task.if_modified_since = update->state.last_modified;
+        }
+        downloader.add(task);
+        return true;
+    };
+
+    std::vector<std::unique_ptr<ComponentUpdate>> updates;
+    for (const auto& component : CACHE_INS->d->components)
     {
-        for (auto suggests : package->suggests)
+        updates.emplace_back(new ComponentUpdate());
+        auto update = updates.back().get();
+        update->name = component;
+        update->path = debarDir + component + ".Packages";
+
+        std::string packagesPath = component + "/binary-" + CACHE_INS->d->arch + "/Packages";
+        update->extension = choose_packages_extension(release, packagesPath);
+        update->state.url = distsUrl + packagesPath + update->extension;
+        auto entry = release.find(packagesPath + update->extension);
+        if (entry) update->state.sha256 = entry->sha256;
+
+        for (const auto& old : oldState.components)
         {
-            __download_package(suggests);
+            if (old.first != component) continue;
+            update->reusable = old.second.url == update->state.url
+                && fs::exists(update->path) && fs::exists(update->path + ".records");
+            if (update->reusable && !update->state.sha256.empty()) {
+                update->unchanged = old.second.sha256 == update->state.sha256;
+            } else if (update->reusable) {
+                update->state = old.second;
+            }
+            break;
+        }
+        if (update->unchanged) continue;
+
+        // A known Packages file can be caught up with the published patches
+        // instead of downloading the whole index again. The patch lists of
+        // all components are fetched together with the full downloads.
+        std::string diffPath = component + "/binary-" + CACHE_INS->d->arch + "/Packages.diff/";
+        if (update->reusable && !update->state.sha256.empty() && release.find(diffPath + "Index")) {
+            update->pdiff.reset(new PDiff(distsUrl + diffPath, update->path));
+            update->pdiff->fetch_index(downloader);
+            continue;
         }
+        if (!download(update)) return false;
     }
+    if (!downloader.run()) return false;
 
-    return true;
-}
+    // Then the patches, and in the same run the full file of every
+    // component that cannot be patched.
+    for (auto& update : updates)
+    {
+        if (!update->pdiff || update->pdiff->fetch_patches(downloader)) continue;
+        update->pdiff.reset();
+        if (!download(update.get())) return false;
+    }
+    if (!downloader.run()) return false;
 
-bool DEBAR::Cache::unzip_gz_file(const std::string &path)
-{
-    gzFile gz_file = gzopen(path.c_str(), "rb");
-    if (!gz_file) {
-        std::cerr << "Failed to open gz file: " << path << std::endl;
-        return false;
+    // A patched file is parsed again as a whole below, patches only save
+    // the download.
+    bool fallback = false;
+    for (auto& update : updates)
+    {
+        if (!update->pdiff) continue;
+        if (update->pdiff->apply_patches(update->path + ".tmp")) {
+            std::cout << "Patched " << update->name << " Packages." << std::endl;
+            update->patched = true;
+        } else if (!download(update.get())) {
+            return false;
+        } else {
+            fallback = true;
+        }
+        update->pdiff.reset();
     }
+    if (fallback && !downloader.run()) return false;
 
-    std::string output_path = path.substr(0, path.find_last_of('.'));
-    std::ofstream out_file(output_path, std::ios::out | std::ios::binary);
-    if (!out_file) {
-        std::cerr << "Failed to create output file: " << output_path << std::endl;
-        gzclose(gz_file);
-        return false;
+    bool allUnchanged = oldState.components.size() == updates.size();
+    for (size_t i = 0; i < updates.size(); i++)
+    {
+        auto& update = updates[i];
+        if (update->response.not_modified) {
+            update->unchanged = true;
+            update->file.close();
+            fs::remove(update->path + ".tmp");
+        } else if (!update->unchanged) {
+            update->state.etag = update->response.etag;
+            update->state.last_modified = update->response.last_modified;
+        }
+        newState.components.emplace_back(update->name, update->state);
+        allUnchanged = allUnchanged && update->unchanged && oldState.components[i].first == update->name;
     }
 
-    char buffer[4096];
-    int bytes_read;
-    while ((bytes_read = gzread(gz_file, buffer, sizeof(buffer))) > 0) {
-        out_file.write(buffer, bytes_read);
+    auto indexPath = debarDir + "index";
+    auto dbPath = debarDir + "packages.db";
+    auto trigramPath = debarDir + "trigram";
+    auto descriptionPath = debarDir + "description";
+    // Files written by an older format do not open and are rebuilt.
+    if (allUnchanged && CACHE_INS->d->index.open(indexPath) && CACHE_INS->d->db.open(dbPath, CACHE_INS->d->index)
+        && CACHE_INS->d->trigram.open(trigramPath) && CACHE_INS->d->description.open(descriptionPath)) {
+        save_update_state(statePath, newState);
+        std::cout << "Cache is up to date." << std::endl;
+        return true;
     }
 
-    if (bytes_read < 0) {
-        int err;
-        const char *error_string = gzerror(gz_file, &err);
-        std::cerr << "gzread error: " << error_string << std::endl;
-        gzclose(gz_file);
-        out_file.close();
-        return false;
+    IndexWriter indexWriter;
+    PackageDBWriter dbWriter;
+    TrigramWriter trigramWriter;
+    DescriptionIndexWriter descriptionWriter;
+    for (auto& update : updates)
+    {
+        if (update->unchanged) {
+            if (!load_records(update->path + ".records", update->records)) {
+                // Records of an older format are parsed again from the kept Packages file.
+                update->records.clear();
+                if (!parse_packages_file(update->path, update->records)
+                    || !save_records(update->path + ".records.tmp", update->records)) {
+                    std::cerr << "Failed to load records of " << update->name << ", run `debar --update` again." << std::endl;
+                    fs::remove(statePath);
+                    return false;
+                }
+                fs::rename(update->path + ".records.tmp", update->path + ".records");
+            }
+        } else if (update->patched) {
+            if (!parse_packages_file(update->path + ".tmp", update->records)) return false;
+            if (!save_records(update->path + ".records.tmp", update->records)) return false;
+        } else {
+            update->file.close();
+            if (!update->decoder->finish() || !update->file) {
+                std::cerr << "Failed to unpack Packages" << update->extension << " of " << update->name << std::endl;
+                return false;
+            }
+            update->scanner->finish();
+            if (!save_records(update->path + ".records.tmp", update->records)) return false;
+        }
+
+        for (const auto& record : update->records)
+        {
+            if (record.name.empty()) continue;
+            uint32_t id = indexWriter.size();
+            indexWriter.add(record.name, record.version);
+            trigramWriter.add(id, record.name);
+            dbWriter.add(record);
+            descriptionWriter.add(id, record.description + record.long_description);
+        }
+        update->records.clear();
     }
 
-    gzclose(gz_file);
-    out_file.close();
+    // Write aside and rename, a mapping of the old index stays valid.
+    if (!indexWriter.write(indexPath + ".tmp")) return false;
+    if (!dbWriter.write(dbPath + ".tmp", indexWriter)) return false;
+    if (!trigramWriter.write(trigramPath + ".tmp", indexWriter.size())) return false;
+    if (!descriptionWriter.write(descriptionPath + ".tmp", indexWriter.size())) return false;
+    for (auto& update : updates)
+    {
+        if (update->unchanged) continue;
+        fs::rename(update->path + ".tmp", update->path);
+        fs::rename(update->path + ".records.tmp", update->path + ".records");
+    }
+    fs::rename(indexPath + ".tmp", indexPath);
+    fs::rename(dbPath + ".tmp", dbPath);
+    fs::rename(trigramPath + ".tmp", trigramPath);
+    fs::rename(descriptionPath + ".tmp", descriptionPath);
+    save_update_state(statePath, newState);
+    CACHE_INS->d->index.open(indexPath);
+    CACHE_INS->d->db.open(dbPath, CACHE_INS->d->index);
+    CACHE_INS->d->trigram.open(trigramPath);
+    CACHE_INS->d->description.open(descriptionPath);
+
+    std::cout << "Update Cache successfully." << std::endl;
     return true;
 }
 
-struct PackageName {
-    std::string name;
-    std::string version;
-};
-
-typedef std::vector<PackageName> PackageItem;
+/**
+ * @brief Check whether a package file is already in place.
+ * @param task The download of the package, with its expected checksums.
+ * @param size The expected file size.
+ * @return true if the file exists and matches the size and checksum.
+ */
+static bool is_downloaded(const DownloadTask& task, uint64_t size)
+{
+    std::error_code error;
+    if (fs::file_size(task.path, error) != size || error) return false;
+
+    MappedFile file;
+    if (!file.open(task.path)) return false;
+    if (!task.sha256.empty()) {
+        SHA256 sha256;
+        sha256.update(file.data(), file.size());
+        return sha256.hex() == task.sha256;
+    }
+    if (!task.md5.empty()) {
+        MD5 md5;
+        md5.update(file.data(), file.size());
+        return md5.hex() == task.md5;
+    }
+    return true;
+}
 
-PackageItem parsePackageItem(const std::string& item) {
-    auto packages = Utils::split_str(item, " | ");
-    PackageItem res;
-    for (auto pkg : packages)
+/**
+ * @brief Measure what each root of a graph adds on its own.
+ * @param graph The resolved graph.
+ * @return Per root, the number and total size of the packages no other
+ *         root reaches.
+ */
+static std::vector<std::pair<size_t, uint64_t>> unique_contribution(const PackageGraph& graph)
+{
+    const auto& roots = graph.roots();
+    std::vector<uint32_t> stamp(graph.size(), UINT32_MAX);
+    std::vector<uint32_t> owner(graph.size());
+    std::vector<uint32_t> reached(graph.size(), 0);
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < roots.size(); root++)
     {
-        auto tmp = Utils::split_str(pkg, " (");
-        PackageName name;
-        name.name = tmp[0];
-        if (name.name.find(":any") != std::string::npos)
-        {
-            name.name = name.name.substr(0, name.name.size() - 4);
-        }
-        
-        if (tmp.size() > 1)
+        stamp[roots[root]] = root;
+        stack.push_back(roots[root]);
+        while (!stack.empty())
         {
-            name.version = tmp[1].substr(0, tmp[1].size() - 1);
+            auto node = stack.back();
+            stack.pop_back();
+            reached[node]++;
+            owner[node] = root;
+            for (auto edges : {graph.depends(node), graph.suggests(node)}) {
+                for (auto dep : edges) {
+                    if (stamp[dep] == root) continue;
+                    stamp[dep] = root;
+                    stack.push_back(dep);
+                }
+            }
         }
-        res.push_back(name);
+    }
+
+    std::vector<std::pair<size_t, uint64_t>> res(roots.size());
+    for (uint32_t node = 0; node < graph.size(); node++)
+    {
+        if (reached[node] != 1) continue;
+        res[owner[node]].first++;
+        res[owner[node]].second += graph[node].size;
     }
     return res;
 }
 
-PackageInfoPtr DEBAR::Cache::get_package_info(const InfoPos& pos)
+bool DEBAR::Cache::download_packages(const std::vector<std::string> &names)
 {
-    if (pos.name.empty()) return {};
-    if (CACHE_INS->d->exclude.find(pos.name) != CACHE_INS->d->exclude.end()) return {};
-
-    std::ifstream packageFile(CACHE_INS->d->path + "/.debar/" + pos.component + ".Packages", std::ios::in);
-    if (!packageFile) {
-        std::cerr << "Failed to open package file: " << pos.component << ".Packages" << std::endl;
-        return {};
+    std::vector<uint32_t> ids;
+    for (const auto& name : names)
+    {
+        auto id = find_package_id(name);
+        if (id == Index::npos) {
+            std::cerr << "package " << name << " is not found." << std::endl;
+            return false;
+        }
+        ids.push_back(id);
+    }
+    std::string dir = CACHE_INS->d->path + "/packages";
+    if (!fs::exists(dir)) {
+        fs::create_directory(dir);
     }
+    auto db = package_db();
+    if (!db) return false;
+    Downloader downloader(CACHE_INS->d->parallel);
+    downloader.set_mirrors(CACHE_INS->d->mirrors);
+    std::vector<std::pair<std::string, std::string>> links;
+    size_t present = 0;
+    size_t stored = 0;
+    // Each package is queued the moment the resolver reaches it, so the
+    // first transfers run while the rest of the graph is still explored.
+    auto queue = [&](uint32_t id) {
+        std::string filename(db->filename(id));
+        DownloadTask task;
+        task.mirror_path = filename;
+        task.path = dir + filename.substr(filename.find_last_of("/"));
+        task.label = "Downloading: " + std::string(db->name(id)) + " (" + std::string(db->version(id)) + ")";
+        task.size = db->package_size(id);
+        task.sha256 = db->sha256(id);
+        if (task.sha256.empty()) task.md5 = db->md5(id);
+        if (is_downloaded(task, task.size)) {
+            present++;
+            return;
+        }
 
-    packageFile.seekg(pos.pos, std::ios::beg);
-
-    PackageInfoPtr package = std::make_shared<PackageInfo>();
-    std::string line;
-    std::string depends_str;
-    std::string suggests_str;
-    while (std::getline(packageFile, line)) {
-        if (line.find("Package: ") == 0) {
-            auto _name = line.substr(9);
-            package->name = _name;
-        } else if (line.find("Version: ") == 0) {
-            package->version = line.substr(9);
-        } else if (line.find("Filename: ") == 0) {
-            package->filename = line.substr(10);
-        } else if (line.find("Size: ") == 0) {
-            package->size = std::stoul(line.substr(6));
-        } else if (line.find("MD5sum: ") == 0) {
-            package->md5 = line.substr(8);
-        } else if (line.find("Depends: ") == 0) {
-            depends_str = line.substr(9);
-        } else if (line.find("Suggests: ") == 0) {
-            suggests_str = line.substr(10);
-        } else if (line.find("Description: ") == 0) {
-            package->description = line.substr(13);
-        } else if (line.empty()) {
-            break;
+        // With a shared store, the file is fetched into the store once and
+        // linked into every work directory that needs it.
+        if (!CACHE_INS->d->store.empty() && !task.sha256.empty()) {
+            auto object = fs::path(CACHE_INS->d->store) / "sha256" / task.sha256.substr(0, 2) / task.sha256;
+            links.emplace_back(object.string(), task.path);
+            task.path = object.string();
+            if (is_downloaded(task, task.size)) {
+                stored++;
+                return;
+            }
+            std::error_code error;
+            fs::create_directories(object.parent_path(), error);
         }
+        downloader.add(task);
+        downloader.poll();
+    };
+    auto graph = resolve_packages(ids, queue);
+    if (graph.empty()) {
+        std::cerr << "All requested packages are excluded." << std::endl;
+        return false;
     }
-    CACHE_INS->d->already_found.insert(std::pair<std::string, PackageInfoPtr>(package->name, package));
 
-    if (!depends_str.empty())
-    {
-        auto depends = Utils::split_str(depends_str, ", ");
-        for (const auto& dep_name : depends)
+    const auto& roots = graph.roots();
+    std::cout << (roots.size() == 1 ? "You want to download package: \n" : "You want to download packages: \n") << std::endl;
+    if (roots.size() == 1) {
+        std::cout << "\t" << graph.root().name << " (" << graph.root().version << ")\n" << std::endl;
+    } else {
+        // Shared dependencies are downloaded once, tell what each package costs on its own.
+        auto unique = unique_contribution(graph);
+        for (size_t i = 0; i < roots.size(); i++)
         {
-            auto dep = parsePackageItem(dep_name);
-            if (CACHE_INS->d->already_found.find(dep[0].name) == CACHE_INS->d->already_found.end())
-            {
-                auto info_pos = find_package_pos(dep[0].name);
-                auto res = get_package_info(info_pos);
-                if (res) package->depends.push_back(res);
-            } else {
-                package->depends.push_back(CACHE_INS->d->already_found[dep[0].name]);
-            }
+            const auto& package = graph[roots[i]];
+            std::cout << "\t" << package.name << " (" << package.version << "), adds " << unique[i].first
+                      << " packages, " << Utils::format_size(unique[i].second) << " on its own" << std::endl;
         }
+        std::cout << std::endl;
     }
-    
-    if (!suggests_str.empty())
+    std::cout << (roots.size() == 1 ? "This package has the following dependencies: \n" : "These packages have the following dependencies: \n") << std::endl;
+    std::cout << "\t";
+    std::vector<bool> isRoot(graph.size(), false);
+    for (auto root : roots) isRoot[root] = true;
+    size_t size = 0;
+    for (uint32_t node = 0; node < graph.size(); node++)
     {
-        auto suggests = Utils::split_str(suggests_str, ", ");
-        for (const auto& suggests_name : suggests)
-        {
-            auto sug = parsePackageItem(suggests_name);
-            if (CACHE_INS->d->already_found.find(sug[0].name) == CACHE_INS->d->already_found.end())
-            {
-                auto info_pos = find_package_pos(sug[0].name);
-                auto res = get_package_info(info_pos);
-                if (res) package->suggests.push_back(res);
-            } else {
-                package->suggests.push_back(CACHE_INS->d->already_found[sug[0].name]);
-            }
+        size += graph[node].size;
+        if (isRoot[node]) continue;
+        std::cout << graph[node].name << " (" << graph[node].version << ")   ";
+    }
+
+    std::cout << "\n" << std::endl;
+    std::cout << "All " << graph.size() << " packages, Total size " << Utils::format_size(size) << ".\n" << std::endl;
+
+    if (present > 0) {
+        std::cout << present << " packages are already downloaded." << std::endl;
+    }
+    if (stored > 0) {
+        std::cout << stored << " packages are taken from the store." << std::endl;
+    }
+    bool ok = downloader.run();
+    for (const auto& link : links)
+    {
+        // A failed download has nothing to link, it is reported already.
+        if (fs::exists(link.first) && !Utils::link_file(link.first, link.second)) ok = false;
+    }
+    if (!ok) {
+        std::cerr << "Some packages failed to download, run `debar --get` again." << std::endl;
+        return false;
+    }
+    std::cout << "All packages are downloaded." << std::endl;
+
+    return true;
+}
+
+bool DEBAR::Cache::get_package_info(uint32_t id, PackageNode &node)
+{
+    if (id == Index::npos) return false;
+    auto db = package_db();
+    if (!db || id >= db->size()) return false;
+
+    node.id = id;
+    node.name = db->name(id);
+    if (CACHE_INS->d->exclude.find(std::string(node.name)) != CACHE_INS->d->exclude.end()) return false;
+    node.version = db->version(id);
+    node.filename = db->filename(id);
+    node.size = db->package_size(id);
+    node.description = db->description(id);
+    return true;
+}
+
+PackageGraph DEBAR::Cache::resolve_package(const std::string &name)
+{
+    auto id = find_package_id(name);
+    if (id == Index::npos) return PackageGraph();
+    return resolve_packages({id});
+}
+
+PackageGraph DEBAR::Cache::resolve_packages(const std::vector<uint32_t> &roots,
+                                            const std::function<void(uint32_t)> &discovered)
+{
+    PackageGraph graph;
+    auto db = package_db();
+    if (!db) return graph;
+
+    Resolver resolver(*db);
+    for (const auto& exclude : CACHE_INS->d->exclude)
+    {
+        auto index = Cache::index();
+        if (!index) break;
+        // Every candidate of the name is left out.
+        for (auto id : index->candidates(exclude)) {
+            resolver.exclude(id);
         }
     }
+    bool suggests = CMD::is_suggests();
+    auto ids = resolver.resolve(roots, suggests, discovered);
+
+    // Edges point to node positions, which follow the closure order.
+    std::unordered_map<uint32_t, uint32_t> positions;
+    positions.reserve(ids.size());
+    for (uint32_t i = 0; i < ids.size(); i++) positions.emplace(ids[i], i);
 
-    return package;
+    graph.reserve(ids.size());
+    for (auto dep : ids)
+    {
+        PackageNode node;
+        get_package_info(dep, node);
+        graph.add(node);
+        for (auto target : db->depends(dep)) {
+            auto found = positions.find(target);
+            if (found != positions.end()) graph.add_depends(found->second);
+        }
+        if (!suggests) continue;
+        for (auto target : db->suggests(dep)) {
+            auto found = positions.find(target);
+            if (found != positions.end()) graph.add_suggests(found->second);
+        }
+    }
+    for (auto root : roots)
+    {
+        auto found = positions.find(root);
+        if (found == positions.end()) continue;
+        graph.add_root(found->second);
+        positions.erase(found);
+    }
+    return graph;
 }
 
+PackageGraph DEBAR::Cache::lookup_package(const std::string &name) {
+    PackageGraph graph;
+    auto id = find_package_id(name);
+    PackageNode root;
+    if (!get_package_info(id, root)) return graph;
+
+    auto db = package_db();
+    std::vector<uint32_t> depends;
+    std::vector<uint32_t> suggests;
+    for (auto dep : db->depends(id)) {
+        PackageNode node;
+        if (get_package_info(dep, node)) depends.push_back(graph.add(node));
+    }
+    for (auto sug : db->suggests(id)) {
+        PackageNode node;
+        if (get_package_info(sug, node)) suggests.push_back(graph.add(node));
+    }
+    graph.add_root(graph.add(root));
+    for (auto dep : depends) graph.add_depends(dep);
+    for (auto sug : suggests) graph.add_suggests(sug);
+    return graph;
+}
 
-PackageInfoPtr DEBAR::Cache::find_package(const std::string &name) {
-    CACHE_INS->d->already_found.clear();
-    auto info = find_package_pos(name);
-    auto res = get_package_info(info);
+std::list<PackageNode> DEBAR::Cache::search_package(const std::string &text) {
+    auto ids = find_package_ids(text);
+    std::list<PackageNode> res;
+    for (auto id : ids) {
+        PackageNode node;
+        if (get_package_info(id, node)) res.push_back(node);
+    }
     return res;
 }
 
-std::list<PackageInfoPtr> DEBAR::Cache::search_package(const std::string &text) {
-    CACHE_INS->d->already_found.clear();
-    auto infos = find_packages_pos(text);
-    std::list<PackageInfoPtr> res;
-    for (auto info_pos : infos) {
-        auto info = get_package_info(info_pos);
-        res.push_back(info);
+Index *DEBAR::Cache::index()
+{
+    auto& index = CACHE_INS->d->index;
+    if (!index.is_open() && !index.open(CACHE_INS->d->path + "/.debar/index")) {
+        std::cerr << "Failed to open index file, you may need to run `debar --update`." << std::endl;
+        return nullptr;
+    }
+    return &index;
+}
+
+std::list<PackageNode> DEBAR::Cache::search_description(const std::string &text, size_t limit) {
+    auto index = Cache::index();
+    if (!index) return {};
+
+    // Hits are record ids, an index written for other records maps them
+    // to the wrong packages.
+    auto& description = CACHE_INS->d->description;
+    if ((!description.is_open() && !description.open(CACHE_INS->d->path + "/.debar/description"))
+        || description.record_count() != index->size()) {
+        std::cerr << "Failed to open description index, you may need to run `debar --update`." << std::endl;
+        return {};
+    }
+
+    std::list<PackageNode> res;
+    for (const auto& hit : description.search(text, limit)) {
+        PackageNode node;
+        if (get_package_info(hit.first, node)) res.push_back(node);
     }
     return res;
 }
 
-InfoPos DEBAR::Cache::find_package_pos(const std::string &name)
+PackageDB *DEBAR::Cache::package_db()
 {
-    if (CACHE_INS->d->already_not_found.find(name) !=
-        CACHE_INS->d->already_not_found.end())
-    {
-        return InfoPos();
-    }
-    
-    std::ifstream indexFile(CACHE_INS->d->path + "/.debar/index", std::ios::in | std::ios::binary);
-    if (!indexFile) {
-        std::cerr << "Failed to open index file." << std::endl;
-        return InfoPos();
-    }
-
-    char packageName[128];
-    char component[128];
-    std::streamoff pos;
-
-    while (indexFile.read(packageName, 128)) {
-        indexFile.read(component, 128);
-        indexFile.read(reinterpret_cast<char*>(&pos), sizeof(std::streamoff));
-        if (name == packageName) {
-            InfoPos infoPos;
-            infoPos.name = packageName;
-            infoPos.component = component;
-            infoPos.pos = pos;
-            return infoPos;
-        }
+    auto index = Cache::index();
+    if (!index) return nullptr;
+    auto& db = CACHE_INS->d->db;
+    if (!db.is_open() && !db.open(CACHE_INS->d->path + "/.debar/packages.db", *index)) {
+        std::cerr << "Failed to open package database, you may need to run `debar --update`." << std::endl;
+        return nullptr;
     }
-    CACHE_INS->d->already_not_found.insert(name);
-    return InfoPos();
+    return &db;
+}
+
+uint32_t DEBAR::Cache::find_package_id(const std::string &name)
+{
+    auto index = Cache::index();
+    if (!index) return Index::npos;
+    return index->find(name);
 }
 
-std::list<InfoPos> Cache::find_packages_pos(const std::string &name) {
+std::list<uint32_t> Cache::find_package_ids(const std::string &name) {
 
     if (CACHE_INS->d->already_not_found.find(name) !=
         CACHE_INS->d->already_not_found.end())
@@ -428,27 +942,25 @@ std::list<InfoPos> Cache::find_packages_pos(const std::string &name) {
         return {};
     }
 
-    std::ifstream indexFile(CACHE_INS->d->path + "/.debar/index", std::ios::in | std::ios::binary);
-    if (!indexFile) {
-        std::cerr << "Failed to open index file." << std::endl;
-        return {};
-    }
+    auto index = Cache::index();
+    if (!index) return {};
 
-    char packageName[128];
-    char component[128];
-    std::streamoff pos;
-
-    std::list<InfoPos> res;
-    while (indexFile.read(packageName, 128)) {
-        indexFile.read(component, 128);
-        indexFile.read(reinterpret_cast<char*>(&pos), sizeof(std::streamoff));
-        if (std::string(packageName).find(name) != std::string::npos) {
-            InfoPos infoPos;
-            infoPos.name = packageName;
-            infoPos.component = component;
-            infoPos.pos = pos;
-            res.push_back(infoPos);
+    std::list<uint32_t> res;
+    auto& trigram = CACHE_INS->d->trigram;
+    if (!trigram.is_open()) trigram.open(CACHE_INS->d->path + "/.debar/trigram");
+    if (name.size() >= 3 && trigram.is_open() && trigram.record_count() == index->size()) {
+        for (auto id : trigram.candidates(name)) {
+            if (index->record(id).name.find(name) != std::string_view::npos) {
+                res.push_back(id);
+            }
         }
+    } else {
+        // Too short for trigrams, or no usable trigram index: scan every record.
+        index->for_each([&](const IndexRecord& record) {
+            if (record.name.find(name) != std::string_view::npos) {
+                res.push_back(record.id);
+            }
+        });
     }
     CACHE_INS->d->already_not_found.insert(name);
     return res;
@@ -6,22 +6,19 @@
  */
 
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "structs.h"
 
 namespace DEBAR {
 
-struct InfoPos
-{
-    std::string name;
-    std::string component;
-    std::streamoff pos;
-};
-
-
+class Index;
+class PackageDB;
 struct CachePrivate;
 class Cache
 {
@@ -44,53 +41,103 @@ public:
     static bool load_work_directory();
 
     /**
-     * @brief Update cache, download Packages.gz.
+     * @brief Update cache, download Packages.gz and build the indexes.
      * @return true if cache updated successfully.
      */
     static bool update_cache();
 
     /**
-     * @brief Download package by name.
+     * @brief Download packages and their shared dependency closure.
+     * @param names The names of packages.
+     * @return true if download packages successfully.
+     */
+    static bool download_packages(const std::vector<std::string>& names);
+
+    /**
+     * @brief Resolve the dependency closure of a package.
+     *
+     * Suggests are followed when `--suggests` is given, excluded packages
+     * are left out.
+     *
      * @param name The name of package.
-     * @return true if download package successfully.
+     * @return The graph of the closure, each package after its dependencies
+     *         unless they form a cycle, the package itself last. Empty if
+     *         the package is not found.
      */
-    static bool download_package(const std::string& name);
+    static PackageGraph resolve_package(const std::string& name);
 
     /**
-     * @brief Find package by name.
+     * @brief Find package by name without resolving the dependency closure.
+     *
+     * Only the direct depends and suggests are in the graph, and those have
+     * no edges of their own.
+     *
      * @param name The name of package.
-     * @return The package info.
+     * @return The graph, the package itself last. Empty if not found.
      */
-    static PackageInfoPtr find_package(const std::string& name);
+    static PackageGraph lookup_package(const std::string& name);
 
     /**
      * @brief Search package by a text.
      * @param text A text for search.
      * @return The text in package name.
      */
-    static std::list<PackageInfoPtr> search_package(const std::string& text);
+    static std::list<PackageNode> search_package(const std::string& text);
+
+    /**
+     * @brief Search package by the words of its description.
+     * @param text Words to search for.
+     * @param limit The maximum number of packages returned.
+     * @return The best matching packages first, ranked by BM25.
+     */
+    static std::list<PackageNode> search_description(const std::string& text, size_t limit);
 
 private:
 
-    static bool __download_package(PackageInfoPtr package);
+    /**
+     * @brief Resolve the shared dependency closure of records.
+     * @param roots The record ids of the packages.
+     * @param discovered Called with each record id as soon as the resolver
+     *        reaches it.
+     * @return The graph, with the packages that are not excluded as roots.
+     */
+    static PackageGraph resolve_packages(const std::vector<uint32_t>& roots,
+                                         const std::function<void(uint32_t)>& discovered = nullptr);
 
     /**
-     * @brief Unzip .gz file.
-     * @param path The path of .gz file.
-     * @return true if unzip file successfully.
+     * @brief Read the package of a record, without dependencies.
+     * @param id The record id.
+     * @param node Receives the package.
+     * @return false if not found or excluded.
      */
-    static bool unzip_gz_file(const std::string& path);
+    static bool get_package_info(uint32_t id, PackageNode& node);
 
-    static PackageInfoPtr get_package_info(const InfoPos& name);
+    /**
+     * @brief Get the package index, mapped on first use.
+     * @return The index, or nullptr if index file is missing or invalid.
+     */
+    static Index* index();
 
     /**
-     * @brief Find package position by name.
+     * @brief Get the package database, mapped on first use.
+     * @return The database, or nullptr if database file is missing or invalid.
+     */
+    static PackageDB* package_db();
+
+    /**
+     * @brief Find package record by name, the newest if several
+     *        components carry the package.
      * @param name The name of package.
-     * @return The package position.
+     * @return The record id, or Index::npos if not found.
      */
-    static InfoPos find_package_pos(const std::string& name);
+    static uint32_t find_package_id(const std::string& name);
 
-    static std::list<InfoPos> find_packages_pos(const std::string& name);
+    /**
+     * @brief Find the records whose package name contains a text.
+     * @param name The text to search.
+     * @return The record ids.
+     */
+    static std::list<uint32_t> find_package_ids(const std::string& name);
 private:
     Cache();
 };
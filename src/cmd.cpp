@@ -1,6 +1,7 @@
 
 #include "cmd.h"
 #include <cxxopts.hpp>
+#include <fstream>
 #include <iostream>
 
 using namespace DEBAR;
@@ -12,11 +13,14 @@ struct DEBAR::CMDPrivate
     bool init = false;
     bool update = false;
     bool search = false;
+    bool search_desc = false;
     bool get = false;
     bool info = false;
     bool suggests = false;
+    bool closure = false;
     bool depends_mermaid = false;
     std::string package;
+    std::vector<std::string> packages;
     std::string text;
 };
 
@@ -43,6 +47,10 @@ bool CMD::is_search() {
     return m_instance->d->search;
 }
 
+bool CMD::is_search_desc() {
+    return m_instance->d->search_desc;
+}
+
 bool DEBAR::CMD::is_get()
 {
     return m_instance->d->get;
@@ -53,6 +61,11 @@ bool DEBAR::CMD::is_suggests()
     return m_instance->d->suggests;
 }
 
+bool DEBAR::CMD::is_closure()
+{
+    return m_instance->d->closure;
+}
+
 bool DEBAR::CMD::is_depends_mermaid()
 {
     return m_instance->d->depends_mermaid;
@@ -63,6 +76,11 @@ std::string DEBAR::CMD::get_package_name()
     return m_instance->d->package;
 }
 
+std::vector<std::string> CMD::get_package_names()
+{
+    return m_instance->d->packages;
+}
+
 std::string CMD::get_text() {
     return m_instance->d->text;
 }
@@ -80,9 +98,12 @@ CMD::CMD(int argc, char const *argv[])
             ("init", "Init repo data in current directory.")
             ("update", "Update repo data in current directory.")
             ("search", "Search deb package.", cxxopts::value<std::string>(), "<text>")
-            ("get", "Download deb package and depends.", cxxopts::value<std::string>(), "<package_name>")
+            ("search-desc", "Search deb package by description, best matches first.", cxxopts::value<std::string>(), "<text>")
+            ("get", "Download deb packages and depends, names separated by commas.", cxxopts::value<std::vector<std::string>>(), "<package_name>")
+            ("get-file", "Download the deb packages listed in a file, one per line.", cxxopts::value<std::string>(), "<path>")
             ("info", "Show info of the deb package.", cxxopts::value<std::string>(), "<package_name>")
             ("suggests", "Think of suggests as depends, must cooperate --get used.")
+            ("closure", "Show the size of all depends, must cooperate --info used.")
             ("depends-mermaid", "Print the dependency relationship using Mermaid.", cxxopts::value<std::string>(), "<package_name>")
             ("help", "Print help");
 
@@ -105,6 +126,10 @@ CMD::CMD(int argc, char const *argv[])
             d->suggests = true;
         }
 
+        if (result.count("closure")) {
+            d->closure = true;
+        }
+
         if (result.count("depends-mermaid")) {
             d->depends_mermaid = true;
             d->package = result["depends-mermaid"].as<std::string>();
@@ -112,7 +137,24 @@ CMD::CMD(int argc, char const *argv[])
 
         if (result.count("get")) {
             d->get = true;
-            d->package = result["get"].as<std::string>();
+            d->packages = result["get"].as<std::vector<std::string>>();
+        }
+
+        if (result.count("get-file")) {
+            auto path = result["get-file"].as<std::string>();
+            std::ifstream file(path);
+            if (!file) {
+                std::cerr << "Failed to open file: " << path << std::endl;
+                exit(1);
+            }
+            std::string line;
+            while (std::getline(file, line)) {
+                auto begin = line.find_first_not_of(" \t\r");
+                if (begin == std::string::npos || line[begin] == '#') continue;
+                auto end = line.find_last_not_of(" \t\r");
+                d->packages.push_back(line.substr(begin, end - begin + 1));
+            }
+            d->get = true;
         }
 
         if (result.count("info")) {
@@ -124,6 +166,11 @@ CMD::CMD(int argc, char const *argv[])
             d->search = true;
             d->text = result["search"].as<std::string>();
         }
+
+        if (result.count("search-desc")) {
+            d->search_desc = true;
+            d->text = result["search-desc"].as<std::string>();
+        }
         
     } catch (const cxxopts::exceptions::exception& e) {
         std::cerr << "Error parsing options: " << e.what() << std::endl;
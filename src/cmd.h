@@ -7,6 +7,7 @@
 
 #pragma once
 #include <string>
+#include <vector>
 
 namespace DEBAR {
 
@@ -48,6 +49,12 @@ public:
      */
     static bool is_search();
 
+    /**
+     * @brief Check if command line has --search-desc argument.
+     * @return true if --search-desc argument is present.
+     */
+    static bool is_search_desc();
+
     /**
      * @brief Check if command line has --get argument.
      * @return true if --get argument is present.
@@ -59,6 +66,12 @@ public:
      * @return true if --suggests argument is present.
      */
     static bool is_suggests();
+
+    /**
+     * @brief Check if command line has --closure argument.
+     * @return true if --closure argument is present.
+     */
+    static bool is_closure();
     
     /**
      * @brief Check if command line has --depends-mermaid argument.
@@ -67,13 +80,19 @@ public:
     static bool is_depends_mermaid();
 
     /**
-     * @brief Get package name from --get argument.
+     * @brief Get package name from --info or --depends-mermaid argument.
      * @return Package name.
      */
     static std::string get_package_name();
 
     /**
-     * @brief Get param from --search argument.
+     * @brief Get package names from --get and --get-file arguments.
+     * @return Package names in command line order.
+     */
+    static std::vector<std::string> get_package_names();
+
+    /**
+     * @brief Get param from --search or --search-desc argument.
      * @return Search text.
      */
     static std::string get_text();
@@ -0,0 +1,106 @@
+#include "deb822.h"
+
+#include <cstring>
+
+using namespace DEBAR;
+
+/**
+ * @brief Find the end of the line starting at a position.
+ * @return The position of its newline, or the size of the text.
+ */
+static size_t line_end(std::string_view text, size_t pos)
+{
+    // glibc's memchr is vectorized, a line is skipped many bytes at a time.
+    auto found = static_cast<const char*>(std::memchr(text.data() + pos, '\n', text.size() - pos));
+    return found ? found - text.data() : text.size();
+}
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+std::string_view Deb822Field::line() const
+{
+    return value.substr(0, value.find('\n'));
+}
+
+std::string_view Deb822Field::folded() const
+{
+    auto pos = value.find('\n');
+    return pos == std::string_view::npos ? std::string_view() : value.substr(pos + 1);
+}
+
+Deb822Stanza::Deb822Stanza(std::string_view text)
+    : m_text(text)
+{
+}
+
+bool Deb822Stanza::next(Deb822Field &field)
+{
+    while (m_pos < m_text.size()) {
+        size_t begin = m_pos;
+        size_t end = line_end(m_text, begin);
+        m_pos = end + 1;
+        // Skip comments and continuation lines without a field.
+        if (begin == end || is_blank(m_text[begin]) || m_text[begin] == '#') continue;
+        auto colon = m_text.substr(begin, end - begin).find(':');
+        if (colon == std::string_view::npos) continue;
+
+        field.name = m_text.substr(begin, colon);
+        size_t value = begin + colon + 1;
+        while (value < end && is_blank(m_text[value])) value++;
+        // A folded value goes on for every line starting with whitespace.
+        while (end + 1 < m_text.size() && is_blank(m_text[end + 1])) end = line_end(m_text, end + 1);
+        field.value = m_text.substr(value, end - value);
+        m_pos = end + 1;
+        return true;
+    }
+    return false;
+}
+
+std::string Deb822Stanza::unfold(std::string_view value)
+{
+    std::string res;
+    res.reserve(value.size());
+    size_t begin = 0;
+    while (begin < value.size()) {
+        size_t end = line_end(value, begin);
+        res.append(value.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return res;
+}
+
+Deb822Parser::Deb822Parser(std::string_view text)
+    : m_text(text)
+{
+}
+
+bool Deb822Parser::next(std::string_view &stanza)
+{
+    // Skip extra blank lines between stanzas.
+    while (m_pos < m_text.size() && m_text[m_pos] == '\n') m_pos++;
+    if (m_pos >= m_text.size()) return false;
+
+    size_t end = find_end(m_text, m_pos);
+    if (end == std::string_view::npos) {
+        stanza = m_text.substr(m_pos);
+        m_pos = m_text.size();
+    } else {
+        stanza = m_text.substr(m_pos, end + 1 - m_pos);
+        m_pos = end + 2;
+    }
+    return true;
+}
+
+size_t Deb822Parser::find_end(std::string_view text, size_t from)
+{
+    while (from < text.size()) {
+        size_t end = line_end(text, from);
+        if (end + 1 >= text.size()) break;
+        if (text[end + 1] == '\n') return end;
+        from = end + 1;
+    }
+    return std::string_view::npos;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief A field of a deb822 stanza, both views point into the parsed text.
+ */
+struct Deb822Field
+{
+    std::string_view name;
+    /**
+     * @brief The value without leading whitespace. A folded value keeps its
+     *        continuation lines, newlines included.
+     */
+    std::string_view value;
+
+    /**
+     * @brief The first line of the value.
+     */
+    std::string_view line() const;
+
+    /**
+     * @brief The continuation lines of a folded value, empty if there are none.
+     */
+    std::string_view folded() const;
+};
+
+/**
+ * @brief Iterates the fields of one deb822 stanza without copying.
+ */
+class Deb822Stanza
+{
+public:
+    explicit Deb822Stanza(std::string_view text);
+
+    /**
+     * @brief Read the next field.
+     * @param field Set to the field.
+     * @return false at the end of the stanza.
+     */
+    bool next(Deb822Field& field);
+
+    /**
+     * @brief Join the lines of a folded value, dropping the newlines.
+     */
+    static std::string unfold(std::string_view value);
+
+private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+};
+
+/**
+ * @brief Splits deb822 text, e.g. a mapped Packages file, into stanzas
+ *        without copying.
+ */
+class Deb822Parser
+{
+public:
+    explicit Deb822Parser(std::string_view text);
+
+    /**
+     * @brief Read the next stanza.
+     * @param stanza Set to the stanza, up to and including its last newline.
+     * @return false when the text is exhausted.
+     */
+    bool next(std::string_view& stanza);
+
+    /**
+     * @brief Find the blank line that ends a stanza.
+     * @param text The text to search.
+     * @param from Where to start searching.
+     * @return The position of the first of two consecutive newlines, or npos.
+     */
+    static size_t find_end(std::string_view text, size_t from);
+
+private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+};
+
+}
@@ -0,0 +1,233 @@
+#include "decoder.h"
+
+#include <iostream>
+#include <lzma.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef DEBAR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace DEBAR;
+
+namespace {
+
+class GzipDecoder : public Decoder
+{
+public:
+    explicit GzipDecoder(Output output)
+        : m_output(output)
+    {
+        memset(&m_stream, 0, sizeof(m_stream));
+        // 32: detect gzip or zlib header automatically.
+        m_ok = inflateInit2(&m_stream, 15 + 32) == Z_OK;
+    }
+
+    ~GzipDecoder() override
+    {
+        inflateEnd(&m_stream);
+    }
+
+    bool write(const char* data, size_t size) override
+    {
+        if (!m_ok) return false;
+        m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_stream.avail_in = size;
+        while (m_stream.avail_in > 0) {
+            if (m_end) {
+                // Another gzip member follows, as produced by `cat a.gz b.gz`.
+                inflateReset(&m_stream);
+                m_end = false;
+            }
+            m_stream.next_out = reinterpret_cast<Bytef*>(m_buffer);
+            m_stream.avail_out = sizeof(m_buffer);
+            int ret = inflate(&m_stream, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                std::cerr << "inflate error: " << (m_stream.msg ? m_stream.msg : "corrupt data") << std::endl;
+                m_ok = false;
+                return false;
+            }
+            size_t produced = sizeof(m_buffer) - m_stream.avail_out;
+            if (produced > 0 && !m_output(m_buffer, produced)) {
+                m_ok = false;
+                return false;
+            }
+            if (ret == Z_STREAM_END) m_end = true;
+            else if (ret == Z_BUF_ERROR && produced == 0) break;
+        }
+        return true;
+    }
+
+    bool finish() override
+    {
+        if (m_ok && !m_end) std::cerr << "inflate error: unexpected end of stream" << std::endl;
+        return m_ok && m_end;
+    }
+
+private:
+    Output m_output;
+    z_stream m_stream;
+    bool m_ok = false;
+    bool m_end = false;
+    char m_buffer[65536];
+};
+
+class XzDecoder : public Decoder
+{
+public:
+    explicit XzDecoder(Output output)
+        : m_output(output)
+    {
+        m_ok = lzma_stream_decoder(&m_stream, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK;
+    }
+
+    ~XzDecoder() override
+    {
+        lzma_end(&m_stream);
+    }
+
+    bool write(const char* data, size_t size) override
+    {
+        if (!m_ok) return false;
+        m_stream.next_in = reinterpret_cast<const uint8_t*>(data);
+        m_stream.avail_in = size;
+        return run(LZMA_RUN);
+    }
+
+    bool finish() override
+    {
+        // LZMA_CONCATENATED only reports the end once told there is no more input.
+        if (!m_ok || !run(LZMA_FINISH)) return false;
+        if (!m_end) std::cerr << "xz error: unexpected end of stream" << std::endl;
+        return m_end;
+    }
+
+private:
+    bool run(lzma_action action)
+    {
+        while (m_stream.avail_in > 0 || action == LZMA_FINISH) {
+            m_stream.next_out = reinterpret_cast<uint8_t*>(m_buffer);
+            m_stream.avail_out = sizeof(m_buffer);
+            lzma_ret ret = lzma_code(&m_stream, action);
+            if (ret != LZMA_OK && ret != LZMA_STREAM_END && ret != LZMA_BUF_ERROR) {
+                std::cerr << "xz error: corrupt data (" << ret << ")" << std::endl;
+                m_ok = false;
+                return false;
+            }
+            size_t produced = sizeof(m_buffer) - m_stream.avail_out;
+            if (produced > 0 && !m_output(m_buffer, produced)) {
+                m_ok = false;
+                return false;
+            }
+            if (ret == LZMA_STREAM_END) {
+                m_end = true;
+                break;
+            }
+            if (produced == 0 && (ret == LZMA_BUF_ERROR || action == LZMA_FINISH)) break;
+        }
+        return true;
+    }
+
+    Output m_output;
+    lzma_stream m_stream = LZMA_STREAM_INIT;
+    bool m_ok = false;
+    bool m_end = false;
+    char m_buffer[65536];
+};
+
+#ifdef DEBAR_HAVE_ZSTD
+class ZstdDecoder : public Decoder
+{
+public:
+    explicit ZstdDecoder(Output output)
+        : m_output(output)
+        , m_stream(ZSTD_createDStream())
+    {
+        m_ok = m_stream && !ZSTD_isError(ZSTD_initDStream(m_stream));
+    }
+
+    ~ZstdDecoder() override
+    {
+        ZSTD_freeDStream(m_stream);
+    }
+
+    bool write(const char* data, size_t size) override
+    {
+        if (!m_ok) return false;
+        ZSTD_inBuffer in = {data, size, 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out = {m_buffer, sizeof(m_buffer), 0};
+            size_t ret = ZSTD_decompressStream(m_stream, &out, &in);
+            if (ZSTD_isError(ret)) {
+                std::cerr << "zstd error: " << ZSTD_getErrorName(ret) << std::endl;
+                m_ok = false;
+                return false;
+            }
+            if (out.pos > 0 && !m_output(m_buffer, out.pos)) {
+                m_ok = false;
+                return false;
+            }
+            // 0 means a frame is complete and flushed, more frames may follow.
+            m_end = ret == 0;
+        }
+        return true;
+    }
+
+    bool finish() override
+    {
+        if (m_ok && !m_end) std::cerr << "zstd error: unexpected end of stream" << std::endl;
+        return m_ok && m_end;
+    }
+
+private:
+    Output m_output;
+    ZSTD_DStream* m_stream;
+    bool m_ok = false;
+    bool m_end = false;
+    char m_buffer[65536];
+};
+#endif
+
+class PlainDecoder : public Decoder
+{
+public:
+    explicit PlainDecoder(Output output)
+        : m_output(output)
+    {
+    }
+
+    bool write(const char* data, size_t size) override
+    {
+        return m_output(data, size);
+    }
+
+    bool finish() override
+    {
+        return true;
+    }
+
+private:
+    Output m_output;
+};
+
+}
+
+std::unique_ptr<Decoder> Decoder::create(const std::string &extension, Output output)
+{
+    if (extension == ".gz") return std::unique_ptr<Decoder>(new GzipDecoder(output));
+    if (extension == ".xz") return std::unique_ptr<Decoder>(new XzDecoder(output));
+#ifdef DEBAR_HAVE_ZSTD
+    if (extension == ".zst") return std::unique_ptr<Decoder>(new ZstdDecoder(output));
+#endif
+    if (extension.empty()) return std::unique_ptr<Decoder>(new PlainDecoder(output));
+    return nullptr;
+}
+
+std::vector<std::string> Decoder::supported_extensions()
+{
+#ifdef DEBAR_HAVE_ZSTD
+    return {".zst", ".xz", ".gz", ""};
+#else
+    return {".xz", ".gz", ""};
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DEBAR {
+
+/**
+ * @brief Streaming decompressor, input is fed in arbitrary chunks.
+ */
+class Decoder
+{
+public:
+    /**
+     * @brief Receives decompressed bytes, returns false to abort.
+     */
+    typedef std::function<bool(const char* data, size_t size)> Output;
+
+    virtual ~Decoder() {}
+
+    /**
+     * @brief Decompress a chunk of input, output is passed on as it is produced.
+     * @return false if input is corrupt or output aborted.
+     */
+    virtual bool write(const char* data, size_t size) = 0;
+
+    /**
+     * @brief Check the stream ended cleanly after the last chunk.
+     */
+    virtual bool finish() = 0;
+
+    /**
+     * @brief Create a decoder for a compressed file extension.
+     * @param extension ".gz", ".xz", ".zst", or "" for uncompressed input.
+     * @param output Receives the decompressed bytes.
+     * @return The decoder, or nullptr if the format is not supported.
+     */
+    static std::unique_ptr<Decoder> create(const std::string& extension, Output output);
+
+    /**
+     * @brief Extensions create() accepts in this build, "" included.
+     */
+    static std::vector<std::string> supported_extensions();
+};
+
+}
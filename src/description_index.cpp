@@ -0,0 +1,228 @@
+#include "description_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+
+#include "varint.h"
+
+using namespace DEBAR;
+
+namespace {
+
+const char DESCRIPTION_MAGIC[4] = {'D', 'B', 'D', 'S'};
+const uint32_t DESCRIPTION_VERSION = 1;
+
+// BM25 parameters, the usual defaults.
+const double BM25_K1 = 1.2;
+const double BM25_B = 0.75;
+
+struct DescriptionHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t term_count;
+    double average_length;
+    uint64_t lengths_offset;
+    uint64_t terms_offset;
+    uint64_t begin_offset;
+    uint64_t postings_offset;
+    uint64_t strings_offset;
+    uint64_t file_size;
+};
+
+bool is_term_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+}
+
+std::vector<std::string> DescriptionIndex::tokenize(std::string_view text)
+{
+    std::vector<std::string> res;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && !is_term_char(text[i])) i++;
+        size_t start = i;
+        while (i < text.size() && is_term_char(text[i])) i++;
+        // Single characters are mostly list markers and noise.
+        if (i - start < 2) continue;
+        std::string term(text.substr(start, i - start));
+        for (auto& c : term) {
+            if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+        }
+        res.push_back(std::move(term));
+    }
+    return res;
+}
+
+void DescriptionIndexWriter::add(uint32_t id, std::string_view text)
+{
+    if (m_lengths.size() <= id) m_lengths.resize(id + 1, 0);
+
+    auto terms = DescriptionIndex::tokenize(text);
+    m_lengths[id] = terms.size();
+    for (auto& term : terms) {
+        auto& list = m_postings[term];
+        if (!list.empty() && list.back().first == id) {
+            list.back().second++;
+        } else {
+            list.emplace_back(id, 1);
+        }
+    }
+}
+
+bool DescriptionIndexWriter::write(const std::string &path, uint32_t record_count) const
+{
+    std::vector<uint32_t> lengths(m_lengths);
+    lengths.resize(record_count, 0);
+    uint64_t total = 0;
+    for (auto len : lengths) total += len;
+
+    std::vector<const std::string*> sorted;
+    sorted.reserve(m_postings.size());
+    for (const auto& it : m_postings) sorted.push_back(&it.first);
+    std::sort(sorted.begin(), sorted.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+
+    std::vector<uint32_t> terms, begin;
+    std::string postings, strings;
+    for (auto term : sorted) {
+        terms.push_back(strings.size());
+        put_varint(strings, term->size());
+        strings.append(*term);
+
+        begin.push_back(postings.size());
+        uint32_t last = 0;
+        for (const auto& posting : m_postings.at(*term)) {
+            put_varint(postings, posting.first - last);
+            put_varint(postings, posting.second);
+            last = posting.first;
+        }
+    }
+    begin.push_back(postings.size());
+
+    DescriptionHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DESCRIPTION_MAGIC, sizeof(header.magic));
+    header.version = DESCRIPTION_VERSION;
+    header.record_count = record_count;
+    header.term_count = terms.size();
+    header.average_length = record_count ? double(total) / record_count : 0;
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.lengths_offset = out.size();
+    out.append(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(uint32_t));
+    header.terms_offset = out.size();
+    out.append(reinterpret_cast<const char*>(terms.data()), terms.size() * sizeof(uint32_t));
+    header.begin_offset = out.size();
+    out.append(reinterpret_cast<const char*>(begin.data()), begin.size() * sizeof(uint32_t));
+    header.postings_offset = out.size();
+    out.append(postings);
+    header.strings_offset = out.size();
+    out.append(strings);
+    header.file_size = out.size();
+    memcpy(&out[0], &header, sizeof(header));
+
+    std::ofstream indexFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!indexFile) {
+        std::cerr << "Failed to create description index: " << path << std::endl;
+        return false;
+    }
+    indexFile.write(out.data(), out.size());
+    indexFile.flush();
+    return static_cast<bool>(indexFile);
+}
+
+bool DescriptionIndex::open(const std::string &path)
+{
+    m_record_count = 0;
+    m_term_count = 0;
+    if (!m_file.open(path)) return false;
+
+    DescriptionHeader header;
+    if (m_file.size() < sizeof(header)) {
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(header));
+    if (memcmp(header.magic, DESCRIPTION_MAGIC, sizeof(header.magic)) != 0
+        || header.version != DESCRIPTION_VERSION
+        || header.file_size != m_file.size()) {
+        m_file.close();
+        return false;
+    }
+
+    const char* base = m_file.data();
+    m_record_count = header.record_count;
+    m_term_count = header.term_count;
+    m_average_length = header.average_length;
+    m_lengths = reinterpret_cast<const uint32_t*>(base + header.lengths_offset);
+    m_terms = reinterpret_cast<const uint32_t*>(base + header.terms_offset);
+    m_begin = reinterpret_cast<const uint32_t*>(base + header.begin_offset);
+    m_postings = reinterpret_cast<const uint8_t*>(base + header.postings_offset);
+    m_strings = reinterpret_cast<const uint8_t*>(base + header.strings_offset);
+    return true;
+}
+
+std::string_view DescriptionIndex::term(uint32_t i) const
+{
+    const uint8_t* p = m_strings + m_terms[i];
+    size_t len = get_varint(p);
+    return std::string_view(reinterpret_cast<const char*>(p), len);
+}
+
+std::vector<std::pair<uint32_t, double>> DescriptionIndex::search(std::string_view text, size_t limit) const
+{
+    std::vector<std::pair<uint32_t, double>> res;
+    if (!is_open() || m_record_count == 0) return res;
+
+    auto query = tokenize(text);
+    std::sort(query.begin(), query.end());
+    query.erase(std::unique(query.begin(), query.end()), query.end());
+
+    std::vector<double> scores(m_record_count, 0);
+    for (const auto& word : query) {
+        uint32_t lo = 0, hi = m_term_count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (term(mid) < word) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == m_term_count || term(lo) != word) continue;
+
+        const uint8_t* p = m_postings + m_begin[lo];
+        const uint8_t* end = m_postings + m_begin[lo + 1];
+        std::vector<std::pair<uint32_t, uint32_t>> postings;
+        uint32_t id = 0;
+        while (p < end) {
+            id += static_cast<uint32_t>(get_varint(p));
+            postings.emplace_back(id, static_cast<uint32_t>(get_varint(p)));
+        }
+
+        double df = postings.size();
+        double idf = std::log((m_record_count - df + 0.5) / (df + 0.5) + 1);
+        for (const auto& posting : postings) {
+            double tf = posting.second;
+            double norm = 1 - BM25_B + BM25_B * m_lengths[posting.first] / (m_average_length > 0 ? m_average_length : 1);
+            scores[posting.first] += idf * tf * (BM25_K1 + 1) / (tf + BM25_K1 * norm);
+        }
+    }
+
+    for (uint32_t i = 0; i < m_record_count; i++) {
+        if (scores[i] > 0) res.emplace_back(i, scores[i]);
+    }
+    auto better = [](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    if (res.size() > limit) {
+        std::partial_sort(res.begin(), res.begin() + limit, res.end(), better);
+        res.resize(limit);
+    } else {
+        std::sort(res.begin(), res.end(), better);
+    }
+    return res;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace DEBAR {
+
+/**
+ * @brief Builds the inverted index over package descriptions written by `--update`.
+ *
+ * Descriptions are split into lower case alphanumeric terms. Layout:
+ *  - header: magic, version, counts, average description length, offsets
+ *  - lengths: uint32 term count of every record
+ *  - terms: uint32 offsets into the term strings, sorted by term
+ *  - begin: uint32 offsets into postings, one more than terms
+ *  - postings: varint pairs of delta encoded record id and term frequency
+ *  - term strings: `varint length` + bytes
+ */
+class DescriptionIndexWriter
+{
+public:
+    /**
+     * @brief Add the description of a record, ids must be ascending.
+     * @param id The record id.
+     * @param text The short and long description.
+     */
+    void add(uint32_t id, std::string_view text);
+
+    /**
+     * @brief Write the index to file.
+     * @param path The path of description index file.
+     * @param record_count Number of records in the package index.
+     * @return true if index written successfully.
+     */
+    bool write(const std::string& path, uint32_t record_count) const;
+
+private:
+    std::unordered_map<std::string, std::vector<std::pair<uint32_t, uint32_t>>> m_postings;
+    std::vector<uint32_t> m_lengths;
+};
+
+/**
+ * @brief Read-only view of the description index, mapped once per process.
+ */
+class DescriptionIndex
+{
+public:
+    /**
+     * @brief Map the description index file.
+     * @param path The path of description index file.
+     * @return true if index loaded successfully.
+     */
+    bool open(const std::string& path);
+
+    bool is_open() const { return m_file.is_open(); }
+
+    uint32_t record_count() const { return m_record_count; }
+
+    /**
+     * @brief Rank records by BM25 score against a query.
+     * @param text The query, split into terms the same way as descriptions.
+     * @param limit The maximum number of results.
+     * @return Record ids with their score, best first.
+     */
+    std::vector<std::pair<uint32_t, double>> search(std::string_view text, size_t limit) const;
+
+    /**
+     * @brief Split a text into lower case alphanumeric terms.
+     */
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    std::string_view term(uint32_t i) const;
+
+    MappedFile m_file;
+    uint32_t m_record_count = 0;
+    uint32_t m_term_count = 0;
+    double m_average_length = 0;
+    const uint32_t* m_lengths = nullptr;
+    const uint32_t* m_terms = nullptr;
+    const uint32_t* m_begin = nullptr;
+    const uint8_t* m_postings = nullptr;
+    const uint8_t* m_strings = nullptr;
+};
+
+}
@@ -0,0 +1,506 @@
+#include "downloader.h"
+
+#include <chrono>
+#include <curl/curl.h>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <vector>
+
+#include "hash.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+using namespace DEBAR;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Transfer
+{
+    DownloadTask task;
+    std::string url;
+    int mirror = -1;
+    uint64_t tried = 0;
+    Transfer* rival = nullptr;
+    bool done = false;
+    std::chrono::steady_clock::time_point started;
+    CURL* curl = nullptr;
+    FILE* fp = nullptr;
+    struct curl_slist* headers = nullptr;
+    std::unique_ptr<MD5> md5;
+    std::unique_ptr<SHA256> sha256;
+    std::string etag;
+    std::string part;
+    std::string range;
+    curl_off_t offset = 0;
+    curl_off_t received = 0;
+    curl_off_t now = 0;
+    curl_off_t total = 0;
+    char error[CURL_ERROR_SIZE];
+};
+
+size_t transfer_write(char* data, size_t size, size_t nmemb, void* ptr)
+{
+    auto transfer = static_cast<Transfer*>(ptr);
+    size *= nmemb;
+    transfer->received += size;
+    if (transfer->md5) transfer->md5->update(data, size);
+    if (transfer->sha256) transfer->sha256->update(data, size);
+    // A short count makes curl abort with CURLE_WRITE_ERROR.
+    if (transfer->task.sink) return transfer->task.sink(data, size) ? size : 0;
+    return fwrite(data, 1, size, transfer->fp);
+}
+
+size_t transfer_header(char* data, size_t size, size_t nmemb, void* ptr)
+{
+    auto transfer = static_cast<Transfer*>(ptr);
+    std::string line(data, size * nmemb);
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        // A new response after a redirect, forget the previous one.
+        transfer->etag.clear();
+        size_t code = line.find(' ');
+        if (transfer->offset > 0 && code != std::string::npos && atoi(line.c_str() + code) == 200) {
+            // The server ignored the Range request and sends the whole file.
+            transfer->offset = 0;
+            transfer->fp = freopen(transfer->part.c_str(), "wb", transfer->fp);
+            if (transfer->md5) transfer->md5.reset(new MD5());
+            if (transfer->sha256) transfer->sha256.reset(new SHA256());
+            if (!transfer->fp) return 0;
+        }
+    } else if (strncasecmp(line.c_str(), "ETag:", 5) == 0) {
+        size_t begin = line.find_first_not_of(" \t", 5);
+        size_t end = line.find_last_not_of(" \t\r\n");
+        if (begin != std::string::npos && end != std::string::npos && end >= begin) {
+            transfer->etag = line.substr(begin, end - begin + 1);
+        }
+    }
+    return size * nmemb;
+}
+
+int transfer_progress(void* ptr, curl_off_t total_to_download, curl_off_t now_downloaded, curl_off_t, curl_off_t)
+{
+    auto transfer = static_cast<Transfer*>(ptr);
+    transfer->total = total_to_download;
+    transfer->now = now_downloaded;
+    return 0;
+}
+
+/**
+ * @brief A queued task, with the mirrors that already failed it.
+ */
+struct Job
+{
+    DownloadTask task;
+    uint64_t tried = 0;
+};
+
+/**
+ * @brief What a run measured about one mirror.
+ */
+struct Mirror
+{
+    std::string url;
+    curl_off_t bytes = 0;
+    double seconds = 0;
+    size_t active = 0;
+    size_t failures = 0;
+};
+
+// A mirror failing this many transfers in a row gets no more work.
+const size_t MIRROR_MAX_FAILURES = 3;
+
+// A transfer is raced on a second mirror once it ran and is expected to
+// still need at least this long.
+const auto RACE_AFTER = std::chrono::seconds(2);
+const double RACE_REMAINING_SECONDS = 2.0;
+
+}
+
+struct DEBAR::DownloaderPrivate
+{
+    size_t parallel = 1;
+    std::deque<Job> queue;
+    std::list<Transfer> running;
+    std::vector<Mirror> mirrors;
+    struct curl_slist* headers = nullptr;
+
+    // Kept across run() calls: the multi handle owns the connection cache,
+    // idle easy handles keep their DNS cache and TLS session.
+    CURLM* multi = nullptr;
+    std::vector<CURL*> idle;
+
+    // Counted from add() to the end of run().
+    size_t task_count = 0;
+    size_t done_count = 0;
+    curl_off_t done_bytes = 0;
+    bool ok = true;
+
+    int pick_mirror(uint64_t tried) const;
+    bool start(CURLM* multi, const Job& job, Transfer* rival = nullptr);
+    void finish(CURLM* multi, Transfer& transfer, CURLcode code);
+    void cancel(CURLM* multi, Transfer& transfer);
+    void release(CURLM* multi, Transfer& transfer);
+    void race(CURLM* multi);
+    void step(CURLM* multi);
+    void print_progress(bool force);
+
+    std::chrono::steady_clock::time_point last_print;
+};
+
+int DownloaderPrivate::pick_mirror(uint64_t tried) const
+{
+    // Untried mirrors count as fast, so every mirror gets measured.
+    int best = -1;
+    double bestScore = 0;
+    for (size_t i = 0; i < mirrors.size(); i++) {
+        const auto& mirror = mirrors[i];
+        if (tried >> i & 1 || mirror.failures >= MIRROR_MAX_FAILURES) continue;
+        double speed = mirror.seconds > 0 ? mirror.bytes / mirror.seconds : 1e12;
+        double score = speed / (mirror.active + 1);
+        if (best < 0 || score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+bool DownloaderPrivate::start(CURLM *multi, const Job &job, Transfer* rival)
+{
+    const auto& task = job.task;
+    int mirror = -1;
+    std::string url = task.url;
+    if (!task.mirror_path.empty() && !mirrors.empty()) {
+        mirror = pick_mirror(job.tried);
+        if (mirror < 0) {
+            if (!rival && !task.quiet) {
+                std::cerr << std::endl << "Failed to download " << task.mirror_path << ": no mirror left" << std::endl;
+            }
+            return false;
+        }
+        url = mirrors[mirror].url;
+        if (!url.empty() && url.back() != '/') url += '/';
+        url += task.mirror_path[0] == '/' ? task.mirror_path.substr(1) : task.mirror_path;
+    }
+
+    running.emplace_back();
+    Transfer& transfer = running.back();
+    transfer.task = task;
+    transfer.url = url;
+    transfer.mirror = mirror;
+    transfer.tried = job.tried;
+    transfer.started = std::chrono::steady_clock::now();
+    transfer.error[0] = '\0';
+    if (!task.md5.empty()) transfer.md5.reset(new MD5());
+    if (!task.sha256.empty()) transfer.sha256.reset(new SHA256());
+    if (!task.sink) {
+        // Resume a part file shorter than the expected size, its bytes go
+        // into the checksums before the rest arrives. A racing transfer
+        // writes its own part file.
+        transfer.part = task.path + (rival ? ".race" : ".part");
+        MappedFile part;
+        if (task.size > 0 && part.open(transfer.part) && part.size() > 0 && part.size() < task.size) {
+            transfer.offset = part.size();
+            if (transfer.md5) transfer.md5->update(part.data(), part.size());
+            if (transfer.sha256) transfer.sha256->update(part.data(), part.size());
+        }
+        part.close();
+        transfer.fp = fopen(transfer.part.c_str(), transfer.offset > 0 ? "ab" : "wb");
+        if (!transfer.fp) {
+            std::cerr << "Failed to open file: " << transfer.part << std::endl;
+            running.pop_back();
+            return false;
+        }
+    }
+    if (rival) {
+        transfer.rival = rival;
+        rival->rival = &transfer;
+    }
+    if (mirror >= 0) mirrors[mirror].active++;
+
+    for (auto header = headers; header; header = header->next) {
+        transfer.headers = curl_slist_append(transfer.headers, header->data);
+    }
+    if (!task.if_none_match.empty()) {
+        transfer.headers = curl_slist_append(transfer.headers, ("If-None-Match: " + task.if_none_match).c_str());
+    }
+
+    if (idle.empty()) {
+        transfer.curl = curl_easy_init();
+    } else {
+        transfer.curl = idle.back();
+        idle.pop_back();
+    }
+    curl_easy_setopt(transfer.curl, CURLOPT_HTTPHEADER, transfer.headers);
+    curl_easy_setopt(transfer.curl, CURLOPT_HEADERFUNCTION, transfer_header);
+    curl_easy_setopt(transfer.curl, CURLOPT_HEADERDATA, &transfer);
+    curl_easy_setopt(transfer.curl, CURLOPT_FILETIME, 1L);
+    if (task.if_modified_since > 0) {
+        curl_easy_setopt(transfer.curl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_IFMODSINCE);
+        curl_easy_setopt(transfer.curl, CURLOPT_TIMEVALUE_LARGE, (curl_off_t)task.if_modified_since);
+    }
+    curl_easy_setopt(transfer.curl, CURLOPT_URL, transfer.url.c_str());
+    if (transfer.offset > 0) {
+        // Unlike CURLOPT_RESUME_FROM, a plain Range lets a server that
+        // ignores it answer with the whole file, handled in transfer_header.
+        transfer.range = std::to_string(transfer.offset) + "-";
+        curl_easy_setopt(transfer.curl, CURLOPT_RANGE, transfer.range.c_str());
+    }
+    curl_easy_setopt(transfer.curl, CURLOPT_WRITEFUNCTION, transfer_write);
+    curl_easy_setopt(transfer.curl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(transfer.curl, CURLOPT_ERRORBUFFER, transfer.error);
+    curl_easy_setopt(transfer.curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(transfer.curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(transfer.curl, CURLOPT_XFERINFOFUNCTION, transfer_progress);
+    curl_easy_setopt(transfer.curl, CURLOPT_XFERINFODATA, &transfer);
+    curl_easy_setopt(transfer.curl, CURLOPT_PRIVATE, &transfer);
+    curl_multi_add_handle(multi, transfer.curl);
+    return true;
+}
+
+void DownloaderPrivate::finish(CURLM *multi, Transfer &transfer, CURLcode code)
+{
+    curl_multi_remove_handle(multi, transfer.curl);
+    if (transfer.fp) fclose(transfer.fp);
+    transfer.fp = nullptr;
+    transfer.done = true;
+
+    // An interrupted transfer keeps its part file to be resumed, a
+    // complete but wrong one is discarded.
+    std::string error;
+    if (code != CURLE_OK) {
+        error = transfer.error[0] ? transfer.error : curl_easy_strerror(code);
+    } else if (transfer.task.size > 0 && uint64_t(transfer.offset + transfer.received) != transfer.task.size) {
+        error = "size mismatch";
+    } else if (transfer.sha256 && transfer.sha256->hex() != transfer.task.sha256) {
+        error = "SHA256 checksum mismatch";
+    } else if (transfer.md5 && transfer.md5->hex() != transfer.task.md5) {
+        error = "MD5 checksum mismatch";
+    }
+
+    if (!transfer.part.empty()) {
+        std::error_code ec;
+        if (error.empty()) {
+            fs::rename(transfer.part, transfer.task.path, ec);
+            if (ec) error = ec.message();
+        } else if (code == CURLE_OK || transfer.rival) {
+            fs::remove(transfer.part, ec);
+        }
+    }
+
+    if (transfer.mirror >= 0) {
+        auto& mirror = mirrors[transfer.mirror];
+        mirror.active--;
+        if (error.empty()) {
+            curl_off_t bytes = 0;
+            curl_off_t micros = 0;
+            curl_easy_getinfo(transfer.curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+            curl_easy_getinfo(transfer.curl, CURLINFO_TOTAL_TIME_T, &micros);
+            mirror.bytes += bytes;
+            mirror.seconds += micros / 1e6;
+            mirror.failures = 0;
+        } else {
+            mirror.failures++;
+        }
+    }
+
+    const char* retry = "";
+    uint64_t tried = transfer.mirror >= 0 ? transfer.tried | uint64_t(1) << transfer.mirror : 0;
+    if (error.empty()) {
+        done_count++;
+        done_bytes += transfer.now;
+        // The first of two racing transfers wins.
+        if (transfer.rival) cancel(multi, *transfer.rival);
+    } else if (transfer.rival) {
+        // The other transfer of the race carries on alone.
+        transfer.rival->rival = nullptr;
+        transfer.rival = nullptr;
+        retry = ", still racing on another mirror";
+    } else if (transfer.mirror >= 0 && pick_mirror(tried) >= 0) {
+        queue.push_front(Job{transfer.task, tried});
+        retry = ", retrying on another mirror";
+    } else {
+        done_count++;
+        done_bytes += transfer.now;
+        if (!transfer.task.quiet) ok = false;
+    }
+
+    if (error.empty() && transfer.task.response) {
+        auto response = transfer.task.response;
+        long status = 0;
+        long unmet = 0;
+        curl_off_t filetime = -1;
+        curl_easy_getinfo(transfer.curl, CURLINFO_RESPONSE_CODE, &status);
+        curl_easy_getinfo(transfer.curl, CURLINFO_CONDITION_UNMET, &unmet);
+        curl_easy_getinfo(transfer.curl, CURLINFO_FILETIME_T, &filetime);
+        response->complete = true;
+        response->not_modified = status == 304 || unmet;
+        response->etag = transfer.etag;
+        response->last_modified = filetime > 0 ? filetime : 0;
+    }
+    if (!error.empty() && !transfer.task.quiet) {
+        print_progress(true);
+        std::cerr << std::endl << "Failed to download " << transfer.url << ": " << error << retry << std::endl;
+    }
+    release(multi, transfer);
+}
+
+void DownloaderPrivate::cancel(CURLM *multi, Transfer &transfer)
+{
+    curl_multi_remove_handle(multi, transfer.curl);
+    if (transfer.fp) fclose(transfer.fp);
+    transfer.fp = nullptr;
+    transfer.done = true;
+    if (!transfer.part.empty()) {
+        std::error_code ec;
+        fs::remove(transfer.part, ec);
+    }
+    if (transfer.mirror >= 0) mirrors[transfer.mirror].active--;
+    transfer.rival = nullptr;
+    release(multi, transfer);
+}
+
+void DownloaderPrivate::release(CURLM *, Transfer &transfer)
+{
+    curl_easy_reset(transfer.curl);
+    idle.push_back(transfer.curl);
+    transfer.curl = nullptr;
+    curl_slist_free_all(transfer.headers);
+    transfer.headers = nullptr;
+}
+
+void DownloaderPrivate::race(CURLM *multi)
+{
+    if (!queue.empty() || running.size() >= parallel) return;
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& transfer : running)
+    {
+        if (transfer.done || transfer.rival || transfer.mirror < 0 || transfer.task.sink) continue;
+        double elapsed = std::chrono::duration<double>(now - transfer.started).count();
+        if (now - transfer.started < RACE_AFTER || transfer.total <= 0) continue;
+        double speed = transfer.now / elapsed;
+        double remaining = transfer.total - transfer.now;
+        if (speed > 0 && remaining / speed < RACE_REMAINING_SECONDS) continue;
+
+        uint64_t tried = transfer.tried | uint64_t(1) << transfer.mirror;
+        if (pick_mirror(tried) < 0) continue;
+        start(multi, Job{transfer.task, tried}, &transfer);
+        return;
+    }
+}
+
+void DownloaderPrivate::step(CURLM *multi)
+{
+    while (running.size() < parallel && !queue.empty()) {
+        Job job = queue.front();
+        queue.pop_front();
+        if (!start(multi, job)) {
+            if (!job.task.quiet) ok = false;
+            done_count++;
+        }
+    }
+    race(multi);
+
+    int still_running = 0;
+    curl_multi_perform(multi, &still_running);
+
+    CURLMsg* msg;
+    int left;
+    while ((msg = curl_multi_info_read(multi, &left))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        Transfer* transfer = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+        if (!transfer || transfer->done) continue;
+        finish(multi, *transfer, msg->data.result);
+        running.remove_if([](const Transfer& t) { return t.done; });
+    }
+}
+
+void DownloaderPrivate::print_progress(bool force)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_print < std::chrono::milliseconds(100)) return;
+    last_print = now;
+
+    curl_off_t bytes = done_bytes;
+    curl_off_t total = done_bytes;
+    for (const auto& transfer : running) {
+        bytes += transfer.now;
+        total += transfer.total > 0 ? transfer.total : transfer.now;
+    }
+
+    std::string label = running.size() == 1 ? running.front().task.label : "Downloading";
+    std::cout << label << " - " << done_count << "/" << task_count << " files";
+    if (total > 0) std::cout << ", " << (bytes * 100 / total) << "%";
+    std::cout << " (" << Utils::format_size(bytes) << " / " << Utils::format_size(total) << ") \r" << std::flush;
+}
+
+Downloader::Downloader(size_t parallel)
+    : d(new DownloaderPrivate())
+{
+    d->parallel = parallel > 0 ? parallel : 1;
+    d->headers = curl_slist_append(d->headers, "User-Agent: Debian APT-HTTP/1.3 (1.0.1ubuntu2)");
+    d->multi = curl_multi_init();
+    if (d->multi) {
+        // Spread transfers over at most `parallel` connections per mirror,
+        // multiplexed when the server speaks HTTP/2.
+        curl_multi_setopt(d->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)d->parallel);
+        curl_multi_setopt(d->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+}
+
+Downloader::~Downloader()
+{
+    for (auto curl : d->idle) curl_easy_cleanup(curl);
+    if (d->multi) curl_multi_cleanup(d->multi);
+    curl_slist_free_all(d->headers);
+    delete d;
+}
+
+void Downloader::set_mirrors(const std::vector<std::string> &mirrors)
+{
+    d->mirrors.clear();
+    for (size_t i = 0; i < mirrors.size() && i < 64; i++) {
+        d->mirrors.push_back(Mirror{mirrors[i]});
+    }
+}
+
+void Downloader::add(const DownloadTask &task)
+{
+    d->queue.push_back(Job{task});
+    d->task_count++;
+}
+
+void Downloader::poll()
+{
+    if (d->multi) d->step(d->multi);
+}
+
+bool Downloader::run()
+{
+    CURLM* multi = d->multi;
+    if (!multi) return false;
+    if (d->task_count == 0) return true;
+
+    while (!d->running.empty() || !d->queue.empty()) {
+        d->step(multi);
+        d->print_progress(false);
+        if (!d->running.empty()) curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+    }
+
+    d->print_progress(true);
+    std::cout << std::endl;
+    bool ok = d->ok;
+    d->task_count = 0;
+    d->done_count = 0;
+    d->done_bytes = 0;
+    d->ok = true;
+    return ok;
+}
\ No newline at end of file
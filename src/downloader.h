@@ -0,0 +1,145 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace DEBAR {
+
+/**
+ * @brief What the server reported about a finished transfer.
+ */
+struct DownloadResponse
+{
+    /**
+     * @brief The transfer succeeded, the other fields are only set then.
+     */
+    bool complete = false;
+
+    /**
+     * @brief The server answered a conditional request with "not modified",
+     *        no body was received.
+     */
+    bool not_modified = false;
+    std::string etag;
+
+    /**
+     * @brief Last-Modified as unix time, 0 if unknown.
+     */
+    int64_t last_modified = 0;
+};
+
+/**
+ * @brief A file to fetch with Downloader.
+ */
+struct DownloadTask
+{
+    std::string url;
+
+    /**
+     * @brief Where the body is saved. It is written to `path.part` first
+     *        and renamed when complete. If `size` is known, a part file
+     *        left by an interrupted transfer is resumed with a Range request.
+     */
+    std::string path;
+    std::string label;
+
+    /**
+     * @brief Receives the body instead of `path` when set, returns false to abort.
+     */
+    std::function<bool(const char* data, size_t size)> sink;
+
+    /**
+     * @brief Expected checksums of the body as hex, verified while it is
+     *        received. Empty means unchecked.
+     */
+    std::string md5;
+    std::string sha256;
+
+    /**
+     * @brief Expected size of the body, 0 means unchecked.
+     */
+    uint64_t size = 0;
+
+    /**
+     * @brief Do not report a failure nor fail run() for it, the caller has
+     *        a fallback and checks `response` to see whether it succeeded.
+     */
+    bool quiet = false;
+
+    /**
+     * @brief Validators of a cached copy, the body is skipped when the
+     *        server reports it unchanged. Empty or 0 means unconditional.
+     */
+    std::string if_none_match;
+    int64_t if_modified_since = 0;
+
+    /**
+     * @brief Filled in when the transfer succeeds, may be nullptr.
+     */
+    DownloadResponse* response = nullptr;
+
+    /**
+     * @brief Path below the mirrors given to Downloader::set_mirrors(), used
+     *        instead of `url` when set so the Downloader can pick the mirror.
+     */
+    std::string mirror_path;
+};
+
+struct DownloaderPrivate;
+
+/**
+ * @brief Runs many downloads concurrently on one curl multi handle.
+ *
+ * Connections and curl handles are reused by later transfers, also across
+ * calls of run(). Progress of all running transfers is printed as one
+ * combined line.
+ *
+ * Tasks with a `mirror_path` are spread over the mirrors: each transfer
+ * goes to the mirror with the best measured throughput per running
+ * transfer, a failed one is retried on another mirror, and once the queue
+ * is empty a slow file is raced on a second mirror.
+ */
+class Downloader
+{
+public:
+    /**
+     * @param parallel The maximum number of concurrent transfers.
+     */
+    explicit Downloader(size_t parallel);
+    ~Downloader();
+
+    Downloader(const Downloader&) = delete;
+    Downloader& operator=(const Downloader&) = delete;
+
+    /**
+     * @brief Set the mirrors `mirror_path` tasks are downloaded from.
+     * @param mirrors The mirror urls, at most 64.
+     */
+    void set_mirrors(const std::vector<std::string>& mirrors);
+
+    /**
+     * @brief Queue a download, it starts in poll() or run().
+     */
+    void add(const DownloadTask& task);
+
+    /**
+     * @brief Start queued downloads and advance running ones without
+     *        waiting, so a caller can keep adding tasks while earlier ones
+     *        are in flight.
+     */
+    void poll();
+
+    /**
+     * @brief Run all queued downloads to the end.
+     * @return true if every download added since the last run() finished
+     *         successfully, quiet ones aside.
+     */
+    bool run();
+
+private:
+    DownloaderPrivate* d;
+};
+
+}
@@ -0,0 +1,232 @@
+#include "hash.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace DEBAR;
+
+namespace {
+
+const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t MD5_K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+const int MD5_S[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t rotl(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/**
+ * @brief Feed bytes through a 64 byte block buffer, shared by both hashes.
+ */
+template <typename Transform>
+void buffer_blocks(const void* data, size_t size, uint8_t* buffer, size_t& buffered, Transform transform)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    if (buffered > 0) {
+        size_t n = std::min(size, 64 - buffered);
+        memcpy(buffer + buffered, p, n);
+        buffered += n;
+        p += n;
+        size -= n;
+        if (buffered < 64) return;
+        transform(buffer);
+        buffered = 0;
+    }
+    while (size >= 64) {
+        transform(p);
+        p += 64;
+        size -= 64;
+    }
+    memcpy(buffer, p, size);
+    buffered = size;
+}
+
+std::string to_hex(const uint8_t* data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string res(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        res[i * 2] = digits[data[i] >> 4];
+        res[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    return res;
+}
+
+}
+
+SHA256::SHA256()
+{
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(m_state, init, sizeof(m_state));
+}
+
+void SHA256::transform(const uint8_t *block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = uint32_t(block[i * 4]) << 24 | uint32_t(block[i * 4 + 1]) << 16
+             | uint32_t(block[i * 4 + 2]) << 8 | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + SHA256_K[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+void SHA256::update(const void *data, size_t size)
+{
+    m_length += size;
+    buffer_blocks(data, size, m_buffer, m_buffered, [this](const uint8_t* block) { transform(block); });
+}
+
+std::string SHA256::hex()
+{
+    uint64_t bits = m_length * 8;
+    uint8_t pad[72] = {0x80};
+    size_t padLength = (m_buffered < 56 ? 56 : 120) - m_buffered;
+    update(pad, padLength);
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = uint8_t(bits >> (56 - i * 8));
+    update(length, 8);
+
+    uint8_t digest[32];
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = uint8_t(m_state[i] >> 24);
+        digest[i * 4 + 1] = uint8_t(m_state[i] >> 16);
+        digest[i * 4 + 2] = uint8_t(m_state[i] >> 8);
+        digest[i * 4 + 3] = uint8_t(m_state[i]);
+    }
+    return to_hex(digest, sizeof(digest));
+}
+
+MD5::MD5()
+{
+    m_state[0] = 0x67452301;
+    m_state[1] = 0xefcdab89;
+    m_state[2] = 0x98badcfe;
+    m_state[3] = 0x10325476;
+}
+
+void MD5::transform(const uint8_t *block)
+{
+    uint32_t m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = uint32_t(block[i * 4]) | uint32_t(block[i * 4 + 1]) << 8
+             | uint32_t(block[i * 4 + 2]) << 16 | uint32_t(block[i * 4 + 3]) << 24;
+    }
+
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    for (int i = 0; i < 64; i++) {
+        uint32_t f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        f += a + MD5_K[i] + m[g];
+        a = d;
+        d = c;
+        c = b;
+        b += rotl(f, MD5_S[i]);
+    }
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+}
+
+void MD5::update(const void *data, size_t size)
+{
+    m_length += size;
+    buffer_blocks(data, size, m_buffer, m_buffered, [this](const uint8_t* block) { transform(block); });
+}
+
+std::string MD5::hex()
+{
+    uint64_t bits = m_length * 8;
+    uint8_t pad[72] = {0x80};
+    size_t padLength = (m_buffered < 56 ? 56 : 120) - m_buffered;
+    update(pad, padLength);
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = uint8_t(bits >> (i * 8));
+    update(length, 8);
+
+    uint8_t digest[16];
+    for (int i = 0; i < 4; i++) {
+        digest[i * 4] = uint8_t(m_state[i]);
+        digest[i * 4 + 1] = uint8_t(m_state[i] >> 8);
+        digest[i * 4 + 2] = uint8_t(m_state[i] >> 16);
+        digest[i * 4 + 3] = uint8_t(m_state[i] >> 24);
+    }
+    return to_hex(digest, sizeof(digest));
+}
\ No newline at end of file
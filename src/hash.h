@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DEBAR {
+
+/**
+ * @brief Incremental SHA-256, data can be fed in any number of chunks.
+ */
+class SHA256
+{
+public:
+    SHA256();
+
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Finish the computation.
+     * @return The digest as lower case hex string.
+     */
+    std::string hex();
+
+private:
+    void transform(const uint8_t* block);
+
+    uint32_t m_state[8];
+    uint64_t m_length = 0;
+    uint8_t m_buffer[64];
+    size_t m_buffered = 0;
+};
+
+/**
+ * @brief Incremental MD5, for the MD5sum field of Packages files.
+ */
+class MD5
+{
+public:
+    MD5();
+
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Finish the computation.
+     * @return The digest as lower case hex string.
+     */
+    std::string hex();
+
+private:
+    void transform(const uint8_t* block);
+
+    uint32_t m_state[4];
+    uint64_t m_length = 0;
+    uint8_t m_buffer[64];
+    size_t m_buffered = 0;
+};
+
+}
@@ -0,0 +1,286 @@
+#include "index.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+
+#include "varint.h"
+
+using namespace DEBAR;
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'D', 'B', 'I', 'X'};
+const uint32_t INDEX_VERSION = 4;
+const uint32_t INDEX_CHECKPOINT = 16;
+// Set in the candidates slot of a name that has a candidate list.
+const uint32_t CANDIDATE_LIST = 0x80000000u;
+
+struct IndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t name_count;
+    uint32_t bucket_count;
+    uint32_t reserved;
+    uint64_t strings_offset;
+    uint64_t records_offset;
+    uint64_t candidates_offset;
+    uint64_t checkpoints_offset;
+    uint64_t buckets_offset;
+    uint64_t file_size;
+};
+
+uint32_t hash_name(const char* str, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t bucket_count_for(size_t names)
+{
+    // Keep the load factor at or below 0.5, probe sequences stay short.
+    uint32_t count = 16;
+    while (count < names * 2) count <<= 1;
+    return count;
+}
+
+}
+
+void IndexWriter::add(const std::string &name, const std::string &version)
+{
+    auto it = m_names.find(name);
+    if (it == m_names.end()) {
+        uint32_t offset = m_strings.size();
+        put_varint(m_strings, name.size());
+        m_strings.append(name);
+        // Filled in by write(), once all records of the name are known.
+        m_strings.append(sizeof(uint32_t), '\0');
+        it = m_names.emplace(name, offset).first;
+        m_name_offsets.push_back(offset);
+    }
+
+    m_records.push_back(Record{it->second, version});
+}
+
+uint32_t IndexWriter::find_name(const std::string &name) const
+{
+    auto it = m_names.find(name);
+    return it == m_names.end() ? Index::npos : it->second;
+}
+
+bool IndexWriter::write(const std::string &path) const
+{
+    std::string records;
+    std::vector<uint32_t> checkpoints;
+    for (uint32_t i = 0; i < m_records.size(); i++) {
+        if (i % INDEX_CHECKPOINT == 0) checkpoints.push_back(records.size());
+        put_varint(records, m_records[i].name);
+    }
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> byName;
+    for (uint32_t i = 0; i < m_records.size(); i++) byName[m_records[i].name].push_back(i);
+
+    // A single record is stored in the slot itself, only names carried by
+    // several components get a list.
+    std::string strings = m_strings;
+    std::string candidates;
+    for (auto& name : byName) {
+        auto& ids = name.second;
+        uint32_t slot = ids.front();
+        if (ids.size() > 1) {
+            std::stable_sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+                return compare_versions(m_records[a].version, m_records[b].version) > 0;
+            });
+            slot = CANDIDATE_LIST | static_cast<uint32_t>(candidates.size());
+            put_varint(candidates, ids.size());
+            for (auto id : ids) {
+                put_varint(candidates, id);
+                put_varint(candidates, m_records[id].version.size());
+                candidates.append(m_records[id].version);
+            }
+        }
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(strings.data());
+        const uint8_t* p = base + name.first;
+        size_t len = get_varint(p);
+        memcpy(&strings[p - base + len], &slot, sizeof(slot));
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.record_count = m_records.size();
+    header.name_count = m_name_offsets.size();
+    header.bucket_count = bucket_count_for(m_name_offsets.size());
+
+    std::vector<uint32_t> buckets(header.bucket_count, 0);
+    const uint32_t mask = header.bucket_count - 1;
+    for (uint32_t offset : m_name_offsets) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(m_strings.data()) + offset;
+        size_t len = get_varint(p);
+        uint32_t slot = hash_name(reinterpret_cast<const char*>(p), len) & mask;
+        while (buckets[slot] != 0) slot = (slot + 1) & mask;
+        buckets[slot] = offset + 1;
+    }
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.strings_offset = out.size();
+    out.append(strings);
+    header.records_offset = out.size();
+    out.append(records);
+    header.candidates_offset = out.size();
+    out.append(candidates);
+    pad_to(out, sizeof(uint32_t));
+    header.checkpoints_offset = out.size();
+    out.append(reinterpret_cast<const char*>(checkpoints.data()), checkpoints.size() * sizeof(uint32_t));
+    header.buckets_offset = out.size();
+    out.append(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint32_t));
+    header.file_size = out.size();
+    memcpy(&out[0], &header, sizeof(header));
+
+    std::ofstream indexFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!indexFile) {
+        std::cerr << "Failed to create index file: " << path << std::endl;
+        return false;
+    }
+    indexFile.write(out.data(), out.size());
+    indexFile.flush();
+    return static_cast<bool>(indexFile);
+}
+
+bool Index::open(const std::string &path)
+{
+    m_strings = nullptr;
+    m_records = nullptr;
+    m_candidates = nullptr;
+    m_checkpoints = nullptr;
+    m_buckets = nullptr;
+    m_record_count = 0;
+    m_bucket_count = 0;
+
+    if (!m_file.open(path)) return false;
+
+    IndexHeader header;
+    if (m_file.size() < sizeof(header)) {
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(header));
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0
+        || header.version != INDEX_VERSION
+        || header.file_size != m_file.size()) {
+        m_file.close();
+        return false;
+    }
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(m_file.data());
+    m_record_count = header.record_count;
+    m_bucket_count = header.bucket_count;
+    m_strings = base + header.strings_offset;
+    m_records = base + header.records_offset;
+    m_candidates = base + header.candidates_offset;
+    m_checkpoints = reinterpret_cast<const uint32_t*>(base + header.checkpoints_offset);
+    m_buckets = reinterpret_cast<const uint32_t*>(base + header.buckets_offset);
+    return true;
+}
+
+std::string_view Index::string_at(uint32_t offset, const uint8_t **end) const
+{
+    const uint8_t* p = m_strings + offset;
+    size_t len = get_varint(p);
+    if (end) *end = p + len;
+    return std::string_view(reinterpret_cast<const char*>(p), len);
+}
+
+uint32_t Index::find_name(std::string_view name) const
+{
+    if (!is_open() || name.empty()) return npos;
+
+    const uint32_t mask = m_bucket_count - 1;
+    uint32_t slot = hash_name(name.data(), name.size()) & mask;
+    while (m_buckets[slot] != 0) {
+        if (string_at(m_buckets[slot] - 1) == name) return m_buckets[slot] - 1;
+        slot = (slot + 1) & mask;
+    }
+    return npos;
+}
+
+uint32_t Index::find(std::string_view name) const
+{
+    return select(find_name(name));
+}
+
+uint32_t Index::select(uint32_t name, VersionOp op, std::string_view constraint) const
+{
+    if (!is_open() || name == npos) return npos;
+
+    const uint8_t* p;
+    string_at(name, &p);
+    uint32_t slot;
+    memcpy(&slot, p, sizeof(slot));
+    if (!(slot & CANDIDATE_LIST)) return slot;
+
+    p = m_candidates + (slot & ~CANDIDATE_LIST);
+    size_t count = get_varint(p);
+    uint32_t first = npos;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t id = static_cast<uint32_t>(get_varint(p));
+        size_t len = get_varint(p);
+        if (i == 0) {
+            first = id;
+            if (op == VersionOp::Any) break;
+        }
+        if (satisfies_version(std::string_view(reinterpret_cast<const char*>(p), len), op, constraint)) return id;
+        p += len;
+    }
+    return first;
+}
+
+std::vector<uint32_t> Index::candidates(std::string_view name) const
+{
+    std::vector<uint32_t> res;
+    uint32_t offset = find_name(name);
+    if (offset == npos) return res;
+
+    const uint8_t* p;
+    string_at(offset, &p);
+    uint32_t slot;
+    memcpy(&slot, p, sizeof(slot));
+    if (!(slot & CANDIDATE_LIST)) {
+        res.push_back(slot);
+        return res;
+    }
+
+    p = m_candidates + (slot & ~CANDIDATE_LIST);
+    size_t count = get_varint(p);
+    res.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        res.push_back(static_cast<uint32_t>(get_varint(p)));
+        p += get_varint(p);
+    }
+    return res;
+}
+
+IndexRecord Index::decode(uint32_t id, const uint8_t *&p) const
+{
+    IndexRecord record;
+    record.id = id;
+    record.name = string_at(static_cast<uint32_t>(get_varint(p)));
+    return record;
+}
+
+IndexRecord Index::record(uint32_t id) const
+{
+    uint32_t first = id - id % INDEX_CHECKPOINT;
+    const uint8_t* p = m_records + m_checkpoints[id / INDEX_CHECKPOINT];
+    for (uint32_t i = first; i < id; i++) get_varint(p);
+    return decode(id, p);
+}
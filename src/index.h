@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "version.h"
+
+namespace DEBAR {
+
+/**
+ * @brief Builds the package index file written by `--update`.
+ *
+ * Layout, all integers little endian:
+ *  - header: magic, version, section counts and offsets
+ *  - string table: every distinct package name once, `varint length` +
+ *    name + `uint32 candidates`, the record id if only one record has the
+ *    name, else CANDIDATE_LIST plus the offset of its candidate list
+ *  - candidate lists: `varint count`, then per record newest version
+ *    first `varint record id` + `varint length` + version
+ *  - records: `varint name offset`
+ *  - checkpoints: byte offset of every INDEX_CHECKPOINT-th record
+ *  - buckets: open addressing hash table of string table offsets
+ */
+class IndexWriter
+{
+public:
+    /**
+     * @brief Append a record to the index.
+     * @param name The name of package.
+     * @param version The version of package.
+     */
+    void add(const std::string& name, const std::string& version);
+
+    /**
+     * @brief Write all sections to file.
+     * @param path The path of index file.
+     * @return true if index written successfully.
+     */
+    bool write(const std::string& path) const;
+
+    /**
+     * @brief Find a package name added so far.
+     * @param name The name of package.
+     * @return The offset of the name to pass to Index::select(), or
+     *         Index::npos if not found.
+     */
+    uint32_t find_name(const std::string& name) const;
+
+    /**
+     * @brief Number of records added so far, also the id of the next one.
+     */
+    uint32_t size() const { return m_records.size(); }
+
+private:
+    struct Record {
+        uint32_t name;
+        std::string version;
+    };
+
+    std::string m_strings;
+    std::unordered_map<std::string, uint32_t> m_names;
+    std::vector<uint32_t> m_name_offsets;
+    std::vector<Record> m_records;
+};
+
+/**
+ * @brief A decoded index record.
+ */
+struct IndexRecord
+{
+    uint32_t id;
+    std::string_view name;
+};
+
+/**
+ * @brief Read-only view of the index file, mapped once per process.
+ */
+class Index
+{
+public:
+    static const uint32_t npos = UINT32_MAX;
+
+    /**
+     * @brief Map the index file.
+     * @param path The path of index file.
+     * @return true if index loaded successfully.
+     */
+    bool open(const std::string& path);
+
+    bool is_open() const { return m_file.is_open(); }
+
+    /**
+     * @brief Number of records in index.
+     */
+    uint32_t size() const { return m_record_count; }
+
+    /**
+     * @brief Find the record with the newest version of a package.
+     *
+     * Candidate lists are sorted when the index is written, this is one
+     * hash lookup whether the name has one record or several.
+     *
+     * @param name The name of package.
+     * @return The record id, or Index::npos if not found.
+     */
+    uint32_t find(std::string_view name) const;
+
+    /**
+     * @brief Pick the newest candidate of a name that satisfies a constraint.
+     *
+     * Candidates are listed newest first with their versions, so the first
+     * one that satisfies is taken and a name with a single candidate costs
+     * no compare at all. If no candidate satisfies the constraint the
+     * newest one is taken, the same as when constraints were not looked at.
+     *
+     * @param name The offset of the name, see IndexWriter::find_name().
+     * @param op The version operator.
+     * @param constraint The version after the operator.
+     * @return The record id, or Index::npos if name is npos.
+     */
+    uint32_t select(uint32_t name, VersionOp op = VersionOp::Any, std::string_view constraint = std::string_view()) const;
+
+    /**
+     * @brief Get every record of a package, e.g. one per component.
+     * @param name The name of package.
+     * @return The record ids, newest version first.
+     */
+    std::vector<uint32_t> candidates(std::string_view name) const;
+
+    /**
+     * @brief Decode a record.
+     * @param id The record id.
+     */
+    IndexRecord record(uint32_t id) const;
+
+    /**
+     * @brief Decode all records in order, faster than calling record() for each id.
+     * @param func Called with every IndexRecord.
+     */
+    template <typename Func>
+    void for_each(Func func) const
+    {
+        const uint8_t* p = m_records;
+        for (uint32_t id = 0; id < m_record_count; id++) {
+            func(decode(id, p));
+        }
+    }
+
+private:
+    IndexRecord decode(uint32_t id, const uint8_t*& p) const;
+    std::string_view string_at(uint32_t offset, const uint8_t** end = nullptr) const;
+    uint32_t find_name(std::string_view name) const;
+
+    MappedFile m_file;
+    const uint8_t* m_strings = nullptr;
+    const uint8_t* m_records = nullptr;
+    const uint8_t* m_candidates = nullptr;
+    const uint32_t* m_checkpoints = nullptr;
+    const uint32_t* m_buckets = nullptr;
+    uint32_t m_record_count = 0;
+    uint32_t m_bucket_count = 0;
+};
+
+}
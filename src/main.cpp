@@ -16,8 +16,8 @@ int main(int argc, char const *argv[]) {
 
     if (DEBAR::CMD::is_depends_mermaid())
     {
-        auto pkg = DEBAR::Cache::find_package(DEBAR::CMD::get_package_name());
-        if (pkg) DEBAR::Mermaid::print_depends(pkg);
+        auto graph = DEBAR::Cache::resolve_package(DEBAR::CMD::get_package_name());
+        DEBAR::Mermaid::print_depends(graph);
         return 0;
     }
     
@@ -29,36 +29,54 @@ int main(int argc, char const *argv[]) {
 
     if (DEBAR::CMD::is_get())
     {
-        auto name = DEBAR::CMD::get_package_name();
-        if (!DEBAR::Cache::download_package(name)) return -1;
+        auto names = DEBAR::CMD::get_package_names();
+        if (!DEBAR::Cache::download_packages(names)) return -1;
     }
 
     if (DEBAR::CMD::is_info()) {
         auto name = DEBAR::CMD::get_package_name();
-        auto pkg = DEBAR::Cache::find_package(name);
-        if (!pkg) {
+        auto graph = DEBAR::Cache::lookup_package(name);
+        if (graph.empty()) {
             std::cerr << "package " << name << " is not found.";
             return -1;
         }
-        std::cout << "Package: " << pkg->name << std::endl;
-        std::cout << "Version: " << pkg->version << std::endl;
-        std::cout << "Size: " << DEBAR::Utils::format_size(pkg->size) << std::endl;
-        std::cout << "Filename: " << pkg->filename << std::endl;
+        const auto& pkg = graph.root();
+        std::cout << "Package: " << pkg.name << std::endl;
+        std::cout << "Version: " << pkg.version << std::endl;
+        std::cout << "Size: " << DEBAR::Utils::format_size(pkg.size) << std::endl;
+        std::cout << "Filename: " << pkg.filename << std::endl;
         std::cout << "Depends: ";
-        for (auto dep : pkg->depends) {
-            std::cout << dep->name << "(" << dep->version << "), ";
+        for (auto dep : graph.depends(graph.roots().front())) {
+            std::cout << graph[dep].name << "(" << graph[dep].version << "), ";
         }
         std::cout << std::endl;
-        std::cout << "Description: " << pkg->description << std::endl;
+        // Resolving every indirect depend is the slow part, only on request.
+        if (DEBAR::CMD::is_closure()) {
+            auto closure = DEBAR::Cache::resolve_package(name);
+            size_t total = 0;
+            for (const auto& dep : closure) total += dep.size;
+            std::cout << "Closure: " << closure.size() << " packages, " << DEBAR::Utils::format_size(total) << std::endl;
+        }
+        std::cout << "Description: " << pkg.description << std::endl;
     }
 
     if (DEBAR::CMD::is_search())
     {
         auto text = DEBAR::CMD::get_text();
         auto packages = DEBAR::Cache::search_package(text);
-        for (auto pkg : packages) {
-            std::cout << pkg->name << " (" << pkg->version << ")" << std::endl;
-            std::cout << "\t" << pkg->description << "\n" << std::endl;
+        for (const auto& pkg : packages) {
+            std::cout << pkg.name << " (" << pkg.version << ")" << std::endl;
+            std::cout << "\t" << pkg.description << "\n" << std::endl;
+        }
+    }
+
+    if (DEBAR::CMD::is_search_desc())
+    {
+        auto text = DEBAR::CMD::get_text();
+        auto packages = DEBAR::Cache::search_description(text, 30);
+        for (const auto& pkg : packages) {
+            std::cout << pkg.name << " (" << pkg.version << ")" << std::endl;
+            std::cout << "\t" << pkg.description << "\n" << std::endl;
         }
     }
 
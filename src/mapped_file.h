@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace DEBAR {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map a file into memory, any previous mapping is released.
+     * @param path The path of file.
+     * @return true if the file mapped successfully.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Release the mapping.
+     */
+    void close();
+
+    bool is_open() const { return m_data != nullptr; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+}
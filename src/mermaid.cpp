@@ -3,26 +3,22 @@
 
 using namespace std;
 
-std::set<std::pair<DEBAR::PackageInfoPtr, DEBAR::PackageInfoPtr>> DEBAR::Mermaid::already_printed;
-
-void DEBAR::Mermaid::print_depends_com(DEBAR::PackageInfoPtr package) {
-    for (auto dep : package->depends)
+void DEBAR::Mermaid::print_depends(const PackageGraph& graph)
+{
+    if (graph.empty()) return;
+    const auto& package = graph.root();
+    cout << "flowchart TD" << endl;
+    cout << "  " << package.name << "{{" << package.name << "}}" << endl;
+    // Every edge of the closure is printed exactly once, starting at the package.
+    for (uint32_t node = graph.size(); node-- > 0;)
     {
-        if (already_printed.find(std::pair<PackageInfoPtr,PackageInfoPtr>(package, dep)) != already_printed.end())
+        for (auto dep : graph.depends(node))
+        {
+            cout << "  " << graph[node].name << " --> " << graph[dep].name << endl;
+        }
+        for (auto sug : graph.suggests(node))
         {
-            continue;
+            cout << "  " << graph[node].name << " -.-> " << graph[sug].name << endl;
         }
-        
-        already_printed.insert(std::pair<PackageInfoPtr,PackageInfoPtr>(package, dep));
-        cout << "  " << package->name << " --> " << dep->name << endl;
-        print_depends_com(dep);
     }
-    
-}
-
-void DEBAR::Mermaid::print_depends(PackageInfoPtr package)
-{
-    cout << "flowchart TD" << endl;
-    cout << "  " << package->name << "{{" << package->name << "}}" << endl;
-    print_depends_com(package);
 }
\ No newline at end of file
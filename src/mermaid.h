@@ -1,6 +1,5 @@
 #pragma once
 
-#include <set>
 #include "structs.h"
 
 namespace DEBAR {
@@ -8,10 +7,10 @@ namespace DEBAR {
 class Mermaid {
 
 public:
-    static void print_depends(PackageInfoPtr package);
-
-private:
-    static void print_depends_com(DEBAR::PackageInfoPtr package);
-    static std::set<std::pair<PackageInfoPtr, PackageInfoPtr>> already_printed;
+    /**
+     * @brief Print the dependency graph of a resolved closure.
+     * @param graph The graph from Cache::resolve_package.
+     */
+    static void print_depends(const PackageGraph& graph);
 };
 };
\ No newline at end of file
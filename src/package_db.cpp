@@ -0,0 +1,374 @@
+#include "package_db.h"
+
+#include <fstream>
+#include <iostream>
+#include <string.h>
+
+#include "index.h"
+#include "varint.h"
+
+using namespace DEBAR;
+
+namespace {
+
+const char DB_MAGIC[4] = {'D', 'B', 'P', 'K'};
+const uint32_t DB_VERSION = 4;
+
+const char RECORDS_MAGIC[4] = {'D', 'B', 'R', 'C'};
+const uint32_t RECORDS_VERSION = 5;
+
+struct DBHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t depends_count;
+    uint32_t suggests_count;
+    uint32_t reserved;
+    uint64_t name_offset;
+    uint64_t version_offset;
+    uint64_t filename_offset;
+    uint64_t description_offset;
+    uint64_t size_offset;
+    uint64_t md5_offset;
+    uint64_t sha256_offset;
+    uint64_t depends_begin_offset;
+    uint64_t depends_offset;
+    uint64_t depends_op_offset;
+    uint64_t depends_version_offset;
+    uint64_t suggests_begin_offset;
+    uint64_t suggests_offset;
+    uint64_t suggests_op_offset;
+    uint64_t suggests_version_offset;
+    uint64_t strings_offset;
+    uint64_t file_size;
+};
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Decode a hex checksum, all zero if it is missing or malformed.
+ */
+void parse_hex(const std::string& hex, uint8_t* out, size_t size)
+{
+    memset(out, 0, size);
+    if (hex.size() != size * 2) return;
+    for (size_t i = 0; i < size; i++) {
+        int hi = hex_value(hex[i * 2]);
+        int lo = hex_value(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            memset(out, 0, size);
+            return;
+        }
+        out[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+}
+
+/**
+ * @brief Encode a checksum column entry, empty if it is all zero.
+ */
+std::string format_hex(const uint8_t* data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    bool empty = true;
+    std::string res(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        if (data[i]) empty = false;
+        res[i * 2] = digits[data[i] >> 4];
+        res[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    return empty ? std::string() : res;
+}
+
+template <typename T>
+uint64_t append_column(std::string& out, const std::vector<T>& column)
+{
+    pad_to(out, sizeof(uint64_t));
+    uint64_t offset = out.size();
+    out.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+    return offset;
+}
+
+void put_string(std::string& out, const std::string& str)
+{
+    put_varint(out, str.size());
+    out.append(str);
+}
+
+void put_dependencies(std::string& out, const std::vector<Dependency>& dependencies)
+{
+    put_varint(out, dependencies.size());
+    for (const auto& dep : dependencies) {
+        put_string(out, dep.name);
+        put_varint(out, static_cast<uint8_t>(dep.op));
+        put_string(out, dep.version);
+    }
+}
+
+bool get_string(const uint8_t*& p, const uint8_t* end, std::string& str)
+{
+    if (p >= end) return false;
+    size_t len = get_varint(p);
+    if (len > size_t(end - p)) return false;
+    str.assign(reinterpret_cast<const char*>(p), len);
+    p += len;
+    return true;
+}
+
+bool get_dependencies(const uint8_t*& p, const uint8_t* end, std::vector<Dependency>& dependencies)
+{
+    if (p >= end) return false;
+    dependencies.resize(get_varint(p));
+    for (auto& dep : dependencies) {
+        if (!get_string(p, end, dep.name) || p >= end) return false;
+        dep.op = static_cast<VersionOp>(get_varint(p));
+        if (!get_string(p, end, dep.version)) return false;
+    }
+    return true;
+}
+
+}
+
+bool DEBAR::save_records(const std::string &path, const std::vector<PackageRecord> &records)
+{
+    std::string out(RECORDS_MAGIC, sizeof(RECORDS_MAGIC));
+    put_varint(out, RECORDS_VERSION);
+    put_varint(out, records.size());
+    for (const auto& record : records) {
+        put_string(out, record.name);
+        put_string(out, record.version);
+        put_string(out, record.filename);
+        put_string(out, record.description);
+        put_string(out, record.md5);
+        put_string(out, record.sha256);
+        put_varint(out, record.size);
+        put_dependencies(out, record.depends);
+        put_dependencies(out, record.suggests);
+        put_string(out, record.long_description);
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to create records file: " << path << std::endl;
+        return false;
+    }
+    file.write(out.data(), out.size());
+    file.flush();
+    return static_cast<bool>(file);
+}
+
+bool DEBAR::load_records(const std::string &path, std::vector<PackageRecord> &records)
+{
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(RECORDS_MAGIC) + 2
+        || memcmp(file.data(), RECORDS_MAGIC, sizeof(RECORDS_MAGIC)) != 0) {
+        return false;
+    }
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(file.data()) + sizeof(RECORDS_MAGIC);
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(file.data()) + file.size();
+    if (get_varint(p) != RECORDS_VERSION) return false;
+
+    size_t count = get_varint(p);
+    records.clear();
+    records.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        PackageRecord record;
+        if (!get_string(p, end, record.name) || !get_string(p, end, record.version)
+            || !get_string(p, end, record.filename) || !get_string(p, end, record.description)
+            || !get_string(p, end, record.md5) || !get_string(p, end, record.sha256) || p >= end) {
+            return false;
+        }
+        record.size = get_varint(p);
+        if (!get_dependencies(p, end, record.depends) || !get_dependencies(p, end, record.suggests)) return false;
+        if (!get_string(p, end, record.long_description)) return false;
+        records.push_back(std::move(record));
+    }
+    return p == end;
+}
+
+uint32_t PackageDBWriter::intern(const std::string &str)
+{
+    auto it = m_string_ids.find(str);
+    if (it != m_string_ids.end()) return it->second;
+
+    uint32_t offset = m_strings.size();
+    put_varint(m_strings, str.size());
+    m_strings.append(str);
+    m_string_ids.emplace(str, offset);
+    return offset;
+}
+
+void PackageDBWriter::add(const PackageRecord &record)
+{
+    Row row;
+    row.name = intern(record.name);
+    row.version = intern(record.version);
+    row.filename = intern(record.filename);
+    row.description = intern(record.description);
+    row.size = record.size;
+    parse_hex(record.md5, row.md5, sizeof(row.md5));
+    parse_hex(record.sha256, row.sha256, sizeof(row.sha256));
+    m_rows.push_back(row);
+    m_depends.emplace_back();
+    for (const auto& dep : record.depends) m_depends.back().push_back(Edge{dep.name, dep.op, intern(dep.version)});
+    m_suggests.emplace_back();
+    for (const auto& sug : record.suggests) m_suggests.back().push_back(Edge{sug.name, sug.op, intern(sug.version)});
+}
+
+bool PackageDBWriter::write(const std::string &path, const IndexWriter &index) const
+{
+    std::vector<uint32_t> name(m_rows.size()), version(m_rows.size()), filename(m_rows.size()), description(m_rows.size());
+    std::vector<uint64_t> size(m_rows.size());
+    std::vector<uint8_t> md5(m_rows.size() * 16);
+    std::vector<uint8_t> sha256(m_rows.size() * 32);
+    for (size_t i = 0; i < m_rows.size(); i++) {
+        name[i] = m_rows[i].name;
+        version[i] = m_rows[i].version;
+        filename[i] = m_rows[i].filename;
+        description[i] = m_rows[i].description;
+        size[i] = m_rows[i].size;
+        memcpy(&md5[i * 16], m_rows[i].md5, 16);
+        memcpy(&sha256[i * 32], m_rows[i].sha256, 32);
+    }
+
+    // Names the index does not know are dropped here, the same as a
+    // failed lookup at resolve time. The candidate is picked when resolving.
+    auto resolve = [&](const std::vector<std::vector<Edge>>& lists, std::vector<uint32_t>& begin,
+                       std::vector<uint32_t>& names, std::vector<uint8_t>& ops, std::vector<uint32_t>& versions) {
+        begin.reserve(lists.size() + 1);
+        for (const auto& list : lists) {
+            begin.push_back(names.size());
+            for (const auto& edge : list) {
+                uint32_t name = index.find_name(edge.name);
+                if (name == Index::npos) continue;
+                names.push_back(name);
+                ops.push_back(static_cast<uint8_t>(edge.op));
+                versions.push_back(edge.version);
+            }
+        }
+        begin.push_back(names.size());
+    };
+    std::vector<uint32_t> dependsBegin, depends, dependsVersion, suggestsBegin, suggests, suggestsVersion;
+    std::vector<uint8_t> dependsOp, suggestsOp;
+    resolve(m_depends, dependsBegin, depends, dependsOp, dependsVersion);
+    resolve(m_suggests, suggestsBegin, suggests, suggestsOp, suggestsVersion);
+
+    DBHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DB_MAGIC, sizeof(header.magic));
+    header.version = DB_VERSION;
+    header.record_count = m_rows.size();
+    header.depends_count = depends.size();
+    header.suggests_count = suggests.size();
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.name_offset = append_column(out, name);
+    header.version_offset = append_column(out, version);
+    header.filename_offset = append_column(out, filename);
+    header.description_offset = append_column(out, description);
+    header.size_offset = append_column(out, size);
+    header.md5_offset = append_column(out, md5);
+    header.sha256_offset = append_column(out, sha256);
+    header.depends_begin_offset = append_column(out, dependsBegin);
+    header.depends_offset = append_column(out, depends);
+    header.depends_op_offset = append_column(out, dependsOp);
+    header.depends_version_offset = append_column(out, dependsVersion);
+    header.suggests_begin_offset = append_column(out, suggestsBegin);
+    header.suggests_offset = append_column(out, suggests);
+    header.suggests_op_offset = append_column(out, suggestsOp);
+    header.suggests_version_offset = append_column(out, suggestsVersion);
+    header.strings_offset = out.size();
+    out.append(m_strings);
+    header.file_size = out.size();
+    memcpy(&out[0], &header, sizeof(header));
+
+    std::ofstream dbFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!dbFile) {
+        std::cerr << "Failed to create package database: " << path << std::endl;
+        return false;
+    }
+    dbFile.write(out.data(), out.size());
+    dbFile.flush();
+    return static_cast<bool>(dbFile);
+}
+
+bool PackageDB::open(const std::string &path, const Index &index)
+{
+    m_record_count = 0;
+    m_index = &index;
+    if (!m_file.open(path)) return false;
+
+    DBHeader header;
+    if (m_file.size() < sizeof(header)) {
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(header));
+    if (memcmp(header.magic, DB_MAGIC, sizeof(header.magic)) != 0
+        || header.version != DB_VERSION
+        || header.file_size != m_file.size()
+        || header.record_count != index.size()) {
+        m_file.close();
+        return false;
+    }
+
+    const char* base = m_file.data();
+    m_record_count = header.record_count;
+    m_name = reinterpret_cast<const uint32_t*>(base + header.name_offset);
+    m_version = reinterpret_cast<const uint32_t*>(base + header.version_offset);
+    m_filename = reinterpret_cast<const uint32_t*>(base + header.filename_offset);
+    m_description = reinterpret_cast<const uint32_t*>(base + header.description_offset);
+    m_size = reinterpret_cast<const uint64_t*>(base + header.size_offset);
+    m_md5 = reinterpret_cast<const uint8_t*>(base + header.md5_offset);
+    m_sha256 = reinterpret_cast<const uint8_t*>(base + header.sha256_offset);
+    m_depends_begin = reinterpret_cast<const uint32_t*>(base + header.depends_begin_offset);
+    m_depends = reinterpret_cast<const uint32_t*>(base + header.depends_offset);
+    m_depends_op = reinterpret_cast<const uint8_t*>(base + header.depends_op_offset);
+    m_depends_version = reinterpret_cast<const uint32_t*>(base + header.depends_version_offset);
+    m_suggests_begin = reinterpret_cast<const uint32_t*>(base + header.suggests_begin_offset);
+    m_suggests = reinterpret_cast<const uint32_t*>(base + header.suggests_offset);
+    m_suggests_op = reinterpret_cast<const uint8_t*>(base + header.suggests_op_offset);
+    m_suggests_version = reinterpret_cast<const uint32_t*>(base + header.suggests_version_offset);
+    m_strings = reinterpret_cast<const uint8_t*>(base + header.strings_offset);
+    return true;
+}
+
+std::string PackageDB::md5(uint32_t id) const
+{
+    return format_hex(m_md5 + size_t(id) * 16, 16);
+}
+
+std::string PackageDB::sha256(uint32_t id) const
+{
+    return format_hex(m_sha256 + size_t(id) * 32, 32);
+}
+
+uint32_t PackageDB::EdgeList::operator[](size_t i) const
+{
+    size_t edge = m_begin + i;
+    return m_db->m_index->select(m_names[edge], static_cast<VersionOp>(m_ops[edge]), m_db->string_at(m_versions[edge]));
+}
+
+PackageDB::EdgeList PackageDB::depends(uint32_t id) const
+{
+    return EdgeList(this, m_depends_begin[id], m_depends_begin[id + 1], m_depends, m_depends_op, m_depends_version);
+}
+
+PackageDB::EdgeList PackageDB::suggests(uint32_t id) const
+{
+    return EdgeList(this, m_suggests_begin[id], m_suggests_begin[id + 1], m_suggests, m_suggests_op, m_suggests_version);
+}
+
+std::string_view PackageDB::string_at(uint32_t offset) const
+{
+    const uint8_t* p = m_strings + offset;
+    size_t len = get_varint(p);
+    return std::string_view(reinterpret_cast<const char*>(p), len);
+}
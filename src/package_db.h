@@ -0,0 +1,222 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "version.h"
+
+namespace DEBAR {
+
+class Index;
+class IndexWriter;
+
+/**
+ * @brief A package named in a relationship field, with its version constraint.
+ */
+struct Dependency
+{
+    std::string name;
+    VersionOp op = VersionOp::Any;
+    std::string version;
+};
+
+/**
+ * @brief Fields of one Packages stanza collected by `--update`.
+ */
+struct PackageRecord
+{
+    std::string name;
+    std::string version;
+    std::string filename;
+    std::string description;
+    std::string md5;
+    std::string sha256;
+    uint64_t size = 0;
+    std::vector<Dependency> depends;
+    std::vector<Dependency> suggests;
+    std::string long_description;
+};
+
+/**
+ * @brief Save the parsed records of one component.
+ *
+ * `--update` reloads them instead of downloading and parsing the
+ * component again when its Packages file did not change.
+ *
+ * @param path The path of records file.
+ * @param records The records in Packages file order.
+ * @return true if records saved successfully.
+ */
+bool save_records(const std::string& path, const std::vector<PackageRecord>& records);
+
+/**
+ * @brief Load records saved by save_records().
+ * @param path The path of records file.
+ * @param records Receives the records.
+ * @return true if records loaded successfully.
+ */
+bool load_records(const std::string& path, std::vector<PackageRecord>& records);
+
+/**
+ * @brief Builds the binary package database written by `--update`.
+ *
+ * Records must be added in the same order as IndexWriter::add() so the
+ * record ids of both files match. The file is columnar, every column is
+ * a fixed size array indexed by record id:
+ *  - name, version, filename, description: string table offsets
+ *  - size: uint64
+ *  - md5: 16 raw bytes
+ *  - sha256: 32 raw bytes
+ *  - depends, suggests: CSR begin offsets into per edge arrays of the
+ *    name offset in the index, the version operator and the version, the
+ *    candidate is picked by Index::select() when resolving
+ *  - string table: `varint length` + bytes, each distinct string once
+ */
+class PackageDBWriter
+{
+public:
+    void add(const PackageRecord& record);
+
+    /**
+     * @brief Resolve dependency names and write the database.
+     * @param path The path of database file.
+     * @param index The index built from the same records, used to map
+     *              dependency names to their candidates.
+     * @return true if database written successfully.
+     */
+    bool write(const std::string& path, const IndexWriter& index) const;
+
+private:
+    uint32_t intern(const std::string& str);
+
+    struct Edge {
+        std::string name;
+        VersionOp op;
+        uint32_t version;
+    };
+
+    struct Row {
+        uint32_t name;
+        uint32_t version;
+        uint32_t filename;
+        uint32_t description;
+        uint64_t size;
+        uint8_t md5[16];
+        uint8_t sha256[32];
+    };
+
+    std::vector<Row> m_rows;
+    std::vector<std::vector<Edge>> m_depends;
+    std::vector<std::vector<Edge>> m_suggests;
+    std::string m_strings;
+    std::unordered_map<std::string, uint32_t> m_string_ids;
+};
+
+/**
+ * @brief Read-only view of the package database, mapped once per process.
+ */
+class PackageDB
+{
+public:
+    /**
+     * @brief The dependencies of a record, each yields the record id
+     *        Index::select() picks for its name and constraint.
+     */
+    class EdgeList
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator(const EdgeList* list, size_t i) : m_list(list), m_i(i) {}
+            uint32_t operator*() const { return (*m_list)[m_i]; }
+            iterator& operator++() { m_i++; return *this; }
+            bool operator!=(const iterator& other) const { return m_i != other.m_i; }
+        private:
+            const EdgeList* m_list;
+            size_t m_i;
+        };
+
+        EdgeList(const PackageDB* db, size_t begin, size_t end, const uint32_t* names,
+                 const uint8_t* ops, const uint32_t* versions)
+            : m_db(db), m_begin(begin), m_end(end), m_names(names), m_ops(ops), m_versions(versions) {}
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, size()); }
+        size_t size() const { return m_end - m_begin; }
+        uint32_t operator[](size_t i) const;
+    private:
+        const PackageDB* m_db;
+        size_t m_begin;
+        size_t m_end;
+        const uint32_t* m_names;
+        const uint8_t* m_ops;
+        const uint32_t* m_versions;
+    };
+
+    /**
+     * @brief Map the database file.
+     * @param path The path of database file.
+     * @param index The index written with the database, dependencies are
+     *              resolved through it.
+     * @return true if database loaded successfully.
+     */
+    bool open(const std::string& path, const Index& index);
+
+    bool is_open() const { return m_file.is_open(); }
+
+    uint32_t size() const { return m_record_count; }
+
+    std::string_view name(uint32_t id) const { return string_at(m_name[id]); }
+    std::string_view version(uint32_t id) const { return string_at(m_version[id]); }
+    std::string_view filename(uint32_t id) const { return string_at(m_filename[id]); }
+    std::string_view description(uint32_t id) const { return string_at(m_description[id]); }
+    uint64_t package_size(uint32_t id) const { return m_size[id]; }
+
+    /**
+     * @brief Get the MD5 checksum as hex string, empty if the stanza has none.
+     */
+    std::string md5(uint32_t id) const;
+
+    /**
+     * @brief Get the SHA256 checksum as hex string, empty if the stanza has none.
+     */
+    std::string sha256(uint32_t id) const;
+
+    /**
+     * @brief The resolvable Depends, first alternative only.
+     */
+    EdgeList depends(uint32_t id) const;
+
+    /**
+     * @brief The resolvable Suggests, first alternative only.
+     */
+    EdgeList suggests(uint32_t id) const;
+
+private:
+    std::string_view string_at(uint32_t offset) const;
+
+    MappedFile m_file;
+    const Index* m_index = nullptr;
+    uint32_t m_record_count = 0;
+    const uint32_t* m_name = nullptr;
+    const uint32_t* m_version = nullptr;
+    const uint32_t* m_filename = nullptr;
+    const uint32_t* m_description = nullptr;
+    const uint64_t* m_size = nullptr;
+    const uint8_t* m_md5 = nullptr;
+    const uint8_t* m_sha256 = nullptr;
+    const uint32_t* m_depends_begin = nullptr;
+    const uint32_t* m_depends = nullptr;
+    const uint8_t* m_depends_op = nullptr;
+    const uint32_t* m_depends_version = nullptr;
+    const uint32_t* m_suggests_begin = nullptr;
+    const uint32_t* m_suggests = nullptr;
+    const uint8_t* m_suggests_op = nullptr;
+    const uint32_t* m_suggests_version = nullptr;
+    const uint8_t* m_strings = nullptr;
+};
+
+}
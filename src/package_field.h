@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief The fields of a Packages stanza debar knows about.
+ *
+ * Installed-Size, Recommends and Provides are recognized but not stored,
+ * they are skipped like unknown fields.
+ */
+enum class PackageField : uint8_t
+{
+    Unknown,
+    Package,
+    Version,
+    Filename,
+    Size,
+    InstalledSize,
+    MD5sum,
+    SHA256,
+    Depends,
+    PreDepends,
+    Recommends,
+    Suggests,
+    Provides,
+    Description,
+};
+
+/**
+ * @brief Recognize a field name.
+ *
+ * The length and first character narrow a name down to at most two
+ * candidates, so an unknown field costs one switch and rarely a compare.
+ *
+ * @param name The field name, case sensitive as written by dak.
+ * @return The field, Unknown if debar does not know it.
+ */
+constexpr PackageField package_field(std::string_view name)
+{
+    switch (name.size()) {
+    case 4:
+        if (name == "Size") return PackageField::Size;
+        break;
+    case 6:
+        if (name[0] == 'M' && name == "MD5sum") return PackageField::MD5sum;
+        if (name[0] == 'S' && name == "SHA256") return PackageField::SHA256;
+        break;
+    case 7:
+        if (name[0] == 'P' && name == "Package") return PackageField::Package;
+        if (name[0] == 'V' && name == "Version") return PackageField::Version;
+        if (name[0] == 'D' && name == "Depends") return PackageField::Depends;
+        break;
+    case 8:
+        if (name[0] == 'F' && name == "Filename") return PackageField::Filename;
+        if (name[0] == 'S' && name == "Suggests") return PackageField::Suggests;
+        if (name[0] == 'P' && name == "Provides") return PackageField::Provides;
+        break;
+    case 10:
+        if (name == "Recommends") return PackageField::Recommends;
+        break;
+    case 11:
+        if (name[0] == 'P' && name == "Pre-Depends") return PackageField::PreDepends;
+        if (name[0] == 'D' && name == "Description") return PackageField::Description;
+        break;
+    case 14:
+        if (name == "Installed-Size") return PackageField::InstalledSize;
+        break;
+    }
+    return PackageField::Unknown;
+}
+
+static_assert(package_field("Pre-Depends") == PackageField::PreDepends, "field table");
+static_assert(package_field("Installed-Size") == PackageField::InstalledSize, "field table");
+static_assert(package_field("Maintainer") == PackageField::Unknown, "field table");
+
+}
@@ -0,0 +1,314 @@
+#include "pdiff.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "decoder.h"
+#include "downloader.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+using namespace DEBAR;
+
+namespace {
+
+struct PDiffEntry
+{
+    std::string sha256;
+    std::string name;
+};
+
+/**
+ * @brief The SHA256 fields of `Packages.diff/Index`.
+ */
+struct PDiffIndex
+{
+    std::string current;
+    std::vector<PDiffEntry> history;
+    std::map<std::string, std::string> patches;
+    bool merged = false;
+
+    bool parse(std::string_view text);
+};
+
+bool starts_with(std::string_view line, std::string_view prefix)
+{
+    return line.size() >= prefix.size() && line.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool PDiffIndex::parse(std::string_view text)
+{
+    enum { NONE, HISTORY, PATCHES } section = NONE;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (line.empty()) continue;
+        if (line[0] != ' ') {
+            section = NONE;
+            if (starts_with(line, "SHA256-Current:")) {
+                size_t p = line.find_first_not_of(' ', 15);
+                if (p != std::string_view::npos) current = std::string(line.substr(p, line.find(' ', p) - p));
+            } else if (starts_with(line, "SHA256-History:")) {
+                section = HISTORY;
+            } else if (starts_with(line, "SHA256-Patches:")) {
+                section = PATCHES;
+            } else if (starts_with(line, "X-Patch-Precedence: merged")) {
+                merged = true;
+            }
+            continue;
+        }
+
+        // " <sha256> <size> <name>"
+        size_t p = line.find_first_not_of(' ');
+        size_t q = line.find(' ', p);
+        if (q == std::string_view::npos) continue;
+        std::string sha256(line.substr(p, q - p));
+        p = line.find_first_not_of(' ', q);
+        q = line.find(' ', p);
+        if (p == std::string_view::npos || q == std::string_view::npos) continue;
+        p = line.find_first_not_of(' ', q);
+        if (p == std::string_view::npos) continue;
+        std::string name(line.substr(p));
+
+        if (section == HISTORY) history.push_back(PDiffEntry{sha256, name});
+        else if (section == PATCHES) patches[name] = sha256;
+    }
+    return !current.empty();
+}
+
+struct EdCommand
+{
+    size_t first;
+    size_t last;
+    char op;
+    std::vector<std::string_view> text;
+};
+
+bool parse_address(std::string_view line, EdCommand& command)
+{
+    size_t i = 0;
+    auto number = [&](size_t& value) {
+        size_t start = i;
+        value = 0;
+        while (i < line.size() && line[i] >= '0' && line[i] <= '9') value = value * 10 + (line[i++] - '0');
+        return i > start;
+    };
+    if (!number(command.first)) return false;
+    command.last = command.first;
+    if (i < line.size() && line[i] == ',') {
+        i++;
+        if (!number(command.last) || command.last < command.first) return false;
+    }
+    if (i + 1 != line.size()) return false;
+    command.op = line[i];
+    return command.op == 'a' || command.op == 'c' || command.op == 'd';
+}
+
+}
+
+bool PDiff::apply(std::string_view input, std::string_view patch, std::string &output)
+{
+    std::vector<std::string_view> patchLines;
+    for (size_t begin = 0; begin < patch.size();) {
+        size_t end = patch.find('\n', begin);
+        if (end == std::string_view::npos) end = patch.size();
+        patchLines.push_back(patch.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    std::vector<EdCommand> commands;
+    for (size_t i = 0; i < patchLines.size(); i++) {
+        auto line = patchLines[i];
+        if (line.empty() || line == "w" || line == "q") continue;
+
+        bool appendMore = line == "a";
+        if (line == "s/.//" || appendMore) {
+            // `diff --ed` writes a lone "." as "..", fixes it with s/.// and
+            // continues appending after it with a bare "a".
+            if (commands.empty() || commands.back().text.empty()) return false;
+            if (!appendMore) {
+                auto& last = commands.back().text.back();
+                if (last.empty() || last[0] != '.') return false;
+                last.remove_prefix(1);
+                continue;
+            }
+        } else {
+            EdCommand command;
+            if (!parse_address(line, command)) return false;
+            commands.push_back(command);
+            if (command.op == 'd') continue;
+        }
+
+        for (i++; i < patchLines.size() && patchLines[i] != "."; i++) {
+            commands.back().text.push_back(patchLines[i]);
+        }
+        if (i == patchLines.size()) return false;
+    }
+
+    std::vector<std::string_view> lines;
+    for (size_t begin = 0; begin < input.size();) {
+        size_t end = input.find('\n', begin);
+        if (end == std::string_view::npos) end = input.size();
+        lines.push_back(input.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    // The script runs bottom up, so every address refers to the original
+    // numbering and the commands can be applied top down in one pass.
+    output.clear();
+    output.reserve(input.size() + patch.size());
+    auto copy = [&](size_t from, size_t to) {
+        for (size_t n = from; n <= to; n++) {
+            output.append(lines[n - 1]);
+            output.push_back('\n');
+        }
+    };
+    size_t next = 1;
+    for (auto it = commands.rbegin(); it != commands.rend(); it++) {
+        const auto& command = *it;
+        if (command.last > lines.size()) return false;
+        if (command.op == 'a') {
+            if (command.first + 1 < next) return false;
+            copy(next, command.first);
+            next = command.first + 1;
+        } else {
+            if (command.first < next || command.first == 0) return false;
+            copy(next, command.first - 1);
+            next = command.last + 1;
+        }
+        for (const auto& text : command.text) {
+            output.append(text);
+            output.push_back('\n');
+        }
+    }
+    copy(next, lines.size());
+    return true;
+}
+
+struct DEBAR::PDiffPrivate
+{
+    std::string diff_url;
+    std::string local_path;
+    std::string index_text;
+    DownloadResponse index_response;
+    PDiffIndex index;
+    std::vector<std::string> names;
+    std::vector<std::string> patches;
+    std::vector<DownloadResponse> responses;
+    std::vector<std::unique_ptr<Decoder>> decoders;
+};
+
+PDiff::PDiff(const std::string &diff_url, const std::string &local_path)
+    : d(new PDiffPrivate())
+{
+    d->diff_url = diff_url;
+    d->local_path = local_path;
+}
+
+PDiff::~PDiff()
+{
+    delete d;
+}
+
+void PDiff::fetch_index(Downloader &downloader)
+{
+    DownloadTask task;
+    task.url = d->diff_url + "Index";
+    task.label = "Downloading Packages.diff/Index";
+    auto& text = d->index_text;
+    task.sink = [&text](const char* data, size_t size) {
+        text.append(data, size);
+        return true;
+    };
+    task.quiet = true;
+    task.response = &d->index_response;
+    downloader.add(task);
+}
+
+bool PDiff::fetch_patches(Downloader &downloader)
+{
+    if (!d->index_response.complete || !d->index.parse(d->index_text)) return false;
+
+    MappedFile local;
+    if (!local.open(d->local_path)) return false;
+    SHA256 localSha;
+    localSha.update(local.data(), local.size());
+    std::string localHash = localSha.hex();
+
+    auto& names = d->names;
+    if (localHash != d->index.current) {
+        auto it = std::find_if(d->index.history.begin(), d->index.history.end(),
+                               [&](const PDiffEntry& entry) { return entry.sha256 == localHash; });
+        if (it == d->index.history.end()) return false;
+        // Merged patches go straight from a historical state to the current one.
+        if (d->index.merged) {
+            names.push_back(it->name);
+        } else {
+            for (; it != d->index.history.end(); it++) names.push_back(it->name);
+        }
+    }
+
+    // Sized once, the tasks keep pointers into them.
+    d->patches.resize(names.size());
+    d->responses.resize(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        auto& patch = d->patches[i];
+        d->decoders.push_back(Decoder::create(".gz", [&patch](const char* data, size_t size) {
+            patch.append(data, size);
+            return true;
+        }));
+        auto decoder = d->decoders.back().get();
+        DownloadTask task;
+        task.url = d->diff_url + names[i] + ".gz";
+        task.label = "Downloading patch " + names[i];
+        task.sink = [decoder](const char* data, size_t size) {
+            return decoder->write(data, size);
+        };
+        task.quiet = true;
+        task.response = &d->responses[i];
+        downloader.add(task);
+    }
+    return true;
+}
+
+bool PDiff::apply_patches(const std::string &out_path)
+{
+    for (const auto& response : d->responses) {
+        if (!response.complete) return false;
+    }
+
+    MappedFile local;
+    if (!local.open(d->local_path)) return false;
+    std::string current(local.data(), local.size());
+    local.close();
+    std::string patched;
+    for (size_t i = 0; i < d->names.size(); i++) {
+        if (!d->decoders[i]->finish()) return false;
+        auto expected = d->index.patches.find(d->names[i]);
+        if (expected != d->index.patches.end()) {
+            SHA256 sha;
+            sha.update(d->patches[i].data(), d->patches[i].size());
+            if (sha.hex() != expected->second) return false;
+        }
+        if (!apply(current, d->patches[i], patched)) return false;
+        current.swap(patched);
+        d->patches[i].clear();
+    }
+
+    SHA256 sha;
+    sha.update(current.data(), current.size());
+    if (sha.hex() != d->index.current) return false;
+
+    std::ofstream out(out_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(current.data(), current.size());
+    out.close();
+    return static_cast<bool>(out);
+}
\ No newline at end of file
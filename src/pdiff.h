@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace DEBAR {
+
+class Downloader;
+struct PDiffPrivate;
+
+/**
+ * @brief Incremental update of a Packages file with the ed-style patches
+ *        mirrors publish under `Packages.diff/`.
+ *
+ * The downloads are queued on the caller's Downloader, so the patches of
+ * every component are fetched together with the other index files:
+ * fetch_index(), run the downloader, fetch_patches(), run it again, then
+ * apply_patches().
+ */
+class PDiff
+{
+public:
+    /**
+     * @param diff_url The url of the `Packages.diff/` directory, ending with '/'.
+     * @param local_path The Packages file to patch, left untouched.
+     */
+    PDiff(const std::string& diff_url, const std::string& local_path);
+    ~PDiff();
+
+    PDiff(const PDiff&) = delete;
+    PDiff& operator=(const PDiff&) = delete;
+
+    /**
+     * @brief Queue the download of `Packages.diff/Index`.
+     */
+    void fetch_index(Downloader& downloader);
+
+    /**
+     * @brief Find the local file in the patch history of the downloaded
+     *        Index and queue the missing patches.
+     * @return false if the local file cannot be patched.
+     */
+    bool fetch_patches(Downloader& downloader);
+
+    /**
+     * @brief Apply the downloaded patches. The result is checked against
+     *        the current checksum in the Index.
+     * @param out_path Where the patched Packages file is written.
+     * @return true if out_path holds the current Packages file.
+     */
+    bool apply_patches(const std::string& out_path);
+
+    /**
+     * @brief Apply an ed script as produced by `diff --ed`.
+     * @param input The text to patch.
+     * @param patch The ed script, commands in descending line order.
+     * @param output Receives the patched text.
+     * @return false if the script is malformed or does not fit the input.
+     */
+    static bool apply(std::string_view input, std::string_view patch, std::string& output);
+
+private:
+    PDiffPrivate* d;
+};
+
+}
@@ -0,0 +1,124 @@
+#include "relation.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace DEBAR;
+
+namespace {
+
+enum : uint8_t
+{
+    SPACE = 1,
+    // Ends a package name or architecture.
+    DELIMITER = 2,
+    OPERATOR = 4,
+};
+
+constexpr std::array<uint8_t, 256> make_classes()
+{
+    std::array<uint8_t, 256> classes{};
+    for (unsigned char c : std::string_view(" \t\r\n")) classes[c] = SPACE | DELIMITER;
+    for (unsigned char c : std::string_view(",|([<:")) classes[c] |= DELIMITER;
+    for (unsigned char c : std::string_view("<=>")) classes[c] |= OPERATOR;
+    return classes;
+}
+
+constexpr auto CLASSES = make_classes();
+
+inline bool is(char c, uint8_t mask)
+{
+    return CLASSES[static_cast<unsigned char>(c)] & mask;
+}
+
+/**
+ * @brief Find the end of a package name or architecture.
+ * @return The first DELIMITER at or after p, or end.
+ */
+inline const char* find_delimiter(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    // Compares 16 bytes against every delimiter at once, debar-bench
+    // measured this faster than one table lookup per byte.
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_setzero_si128();
+        for (char c : std::string_view(" \t\r\n,|([<:")) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && !is(*p, DELIMITER)) p++;
+    return p;
+}
+
+}
+
+RelationParser::RelationParser(std::string_view value)
+    : m_value(value)
+{
+}
+
+bool RelationParser::next(Relation &relation)
+{
+    const char* p = m_value.data() + m_pos;
+    const char* end = m_value.data() + m_value.size();
+    for (; p < end; p++) {
+        if (*p == ',') m_alternative = false;
+        else if (*p == '|') m_alternative = true;
+        else if (!is(*p, SPACE)) break;
+    }
+    if (p == end) {
+        m_pos = m_value.size();
+        return false;
+    }
+
+    relation = Relation();
+    relation.alternative = m_alternative;
+    m_alternative = false;
+
+    const char* begin = p;
+    p = find_delimiter(p, end);
+    relation.name = std::string_view(begin, p - begin);
+    if (p < end && *p == ':') {
+        begin = ++p;
+        p = find_delimiter(p, end);
+        relation.arch = std::string_view(begin, p - begin);
+    }
+
+    while (p < end) {
+        if (is(*p, SPACE)) {
+            p++;
+            continue;
+        }
+        // The closing bracket is found with memchr, nothing in between is
+        // looked at twice.
+        char close;
+        if (*p == '(') close = ')';
+        else if (*p == '[') close = ']';
+        else if (*p == '<') close = '>';
+        else break;
+        auto found = static_cast<const char*>(std::memchr(p + 1, close, end - p - 1));
+        const char* last = found ? found : end;
+        if (close == ')') {
+            const char* q = p + 1;
+            while (q < last && is(*q, SPACE)) q++;
+            begin = q;
+            while (q < last && is(*q, OPERATOR)) q++;
+            relation.op = std::string_view(begin, q - begin);
+            while (q < last && is(*q, SPACE)) q++;
+            begin = q;
+            while (q < last && !is(*q, SPACE)) q++;
+            relation.version = std::string_view(begin, q - begin);
+        }
+        p = found ? found + 1 : end;
+    }
+    m_pos = p - m_value.data();
+    return true;
+}
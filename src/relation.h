@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief One package of a relationship field such as Depends, all views
+ *        point into the field value.
+ */
+struct Relation
+{
+    std::string_view name;
+    /**
+     * @brief The architecture qualifier after `:`, e.g. `any`, or empty.
+     */
+    std::string_view arch;
+    /**
+     * @brief The version operator, `<<`, `<=`, `=`, `>=`, `>>` or the
+     *        obsolete `<` and `>`, empty if the version is not constrained.
+     */
+    std::string_view op;
+    std::string_view version;
+    /**
+     * @brief true if this is an alternative to the previous relation, it
+     *        followed a `|`.
+     */
+    bool alternative = false;
+};
+
+/**
+ * @brief Tokenizes a relationship field in a single pass without
+ *        allocating.
+ *
+ * Folded values need no unfolding, newlines count as whitespace.
+ * Architecture restrictions `[...]` and build profiles `<...>` are
+ * skipped.
+ */
+class RelationParser
+{
+public:
+    explicit RelationParser(std::string_view value);
+
+    /**
+     * @brief Read the next relation.
+     * @param relation Set to the relation.
+     * @return false at the end of the value.
+     */
+    bool next(Relation& relation);
+
+private:
+    std::string_view m_value;
+    size_t m_pos = 0;
+    bool m_alternative = false;
+};
+
+}
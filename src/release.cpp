@@ -0,0 +1,78 @@
+#include "release.h"
+
+using namespace DEBAR;
+
+namespace {
+
+bool starts_with(std::string_view line, std::string_view prefix)
+{
+    return line.size() >= prefix.size() && line.compare(0, prefix.size(), prefix) == 0;
+}
+
+}
+
+bool Release::parse(std::string_view text)
+{
+    m_files.clear();
+
+    enum { NONE, SIZES, SHA256 } section = NONE;
+    bool signedMessage = false;
+    bool inHeader = false;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(begin, end - begin);
+        begin = end + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        // InRelease is a clearsigned message: armor header lines, a blank
+        // line, the Release text, then the signature.
+        if (starts_with(line, "-----BEGIN PGP SIGNED MESSAGE-----")) {
+            signedMessage = true;
+            inHeader = true;
+            continue;
+        }
+        if (inHeader) {
+            if (line.empty()) inHeader = false;
+            continue;
+        }
+        if (signedMessage && starts_with(line, "-----BEGIN PGP SIGNATURE-----")) break;
+
+        if (line.empty()) continue;
+        if (line[0] != ' ') {
+            if (starts_with(line, "SHA256:")) section = SHA256;
+            else if (starts_with(line, "MD5Sum:") || starts_with(line, "SHA1:")) section = SIZES;
+            else section = NONE;
+            continue;
+        }
+        if (section == NONE) continue;
+
+        // " <hash> <size> <path>"
+        size_t p = line.find_first_not_of(' ');
+        size_t q = line.find(' ', p);
+        if (q == std::string_view::npos) continue;
+        std::string_view hash = line.substr(p, q - p);
+        p = line.find_first_not_of(' ', q);
+        q = line.find(' ', p);
+        if (p == std::string_view::npos || q == std::string_view::npos) continue;
+        uint64_t size = 0;
+        for (char c : line.substr(p, q - p)) {
+            if (c < '0' || c > '9') break;
+            size = size * 10 + (c - '0');
+        }
+        p = line.find_first_not_of(' ', q);
+        if (p == std::string_view::npos) continue;
+
+        auto& entry = m_files[std::string(line.substr(p))];
+        entry.size = size;
+        if (section == SHA256) entry.sha256 = std::string(hash);
+    }
+    return !m_files.empty();
+}
+
+const ReleaseEntry *Release::find(const std::string &path) const
+{
+    auto it = m_files.find(path);
+    return it == m_files.end() ? nullptr : &it->second;
+}
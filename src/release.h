@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief A file listed in a Release file.
+ */
+struct ReleaseEntry
+{
+    std::string sha256;
+    uint64_t size = 0;
+};
+
+/**
+ * @brief The file list of a `Release` or clearsigned `InRelease` file.
+ */
+class Release
+{
+public:
+    /**
+     * @brief Parse the text of a Release file, the signature is not checked.
+     * @param text The content of `Release` or `InRelease`.
+     * @return true if any file entry was found.
+     */
+    bool parse(std::string_view text);
+
+    /**
+     * @brief Find a file entry.
+     * @param path The path relative to the dists directory, e.g. `main/binary-amd64/Packages.xz`.
+     * @return The entry, or nullptr if the file is not listed.
+     */
+    const ReleaseEntry* find(const std::string& path) const;
+
+private:
+    std::map<std::string, ReleaseEntry> m_files;
+};
+
+}
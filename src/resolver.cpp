@@ -0,0 +1,59 @@
+#include "resolver.h"
+
+#include "package_db.h"
+
+using namespace DEBAR;
+
+Resolver::Resolver(const PackageDB &db)
+    : m_db(db), m_excluded(db.size(), false)
+{
+}
+
+void Resolver::exclude(uint32_t id)
+{
+    if (id < m_excluded.size()) m_excluded[id] = true;
+}
+
+std::vector<uint32_t> Resolver::resolve(const std::vector<uint32_t>& roots, bool suggests,
+                                        const std::function<void(uint32_t)>& discovered) const
+{
+    struct Frame
+    {
+        uint32_t id;
+        uint32_t next;
+    };
+
+    // Excluded packages count as visited, so they are never entered.
+    std::vector<bool> visited(m_excluded);
+    std::vector<uint32_t> closure;
+    std::vector<Frame> stack;
+    for (auto root : roots)
+    {
+        if (root >= m_db.size() || visited[root]) continue;
+        visited[root] = true;
+        if (discovered) discovered(root);
+        stack.push_back(Frame{root, 0});
+        while (!stack.empty())
+        {
+            auto& frame = stack.back();
+            auto depends = m_db.depends(frame.id);
+            auto edges = suggests ? depends.size() + m_db.suggests(frame.id).size() : depends.size();
+            if (frame.next == edges) {
+                // Post-order: every dependency not on the stack is already emitted.
+                closure.push_back(frame.id);
+                stack.pop_back();
+                continue;
+            }
+
+            uint32_t dep = frame.next < depends.size()
+                ? depends[frame.next]
+                : m_db.suggests(frame.id)[frame.next - depends.size()];
+            frame.next++;
+            if (visited[dep]) continue;
+            visited[dep] = true;
+            if (discovered) discovered(dep);
+            stack.push_back(Frame{dep, 0});
+        }
+    }
+    return closure;
+}
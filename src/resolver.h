@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace DEBAR {
+
+class PackageDB;
+
+/**
+ * @brief Computes the dependency closure of packages in the database.
+ *
+ * The graph is walked depth first with an explicit stack and a visited
+ * bitset over record ids, so deep or cyclic graphs cost neither native
+ * stack nor repeated visits. Every dependency is the candidate
+ * Index::select() picks for its version constraint.
+ */
+class Resolver
+{
+public:
+    explicit Resolver(const PackageDB& db);
+
+    /**
+     * @brief Leave a package out of every closure, its dependencies are
+     *        only included if reachable through other packages.
+     * @param id The record id.
+     */
+    void exclude(uint32_t id);
+
+    /**
+     * @brief Resolve the shared closure of packages.
+     * @param roots The record ids of the packages.
+     * @param suggests Follow Suggests as well as Depends.
+     * @param discovered Called with each record id as soon as it is first
+     *        reached, long before the closure is complete.
+     * @return The record ids, each once, every package after its
+     *         dependencies except where they form a cycle. Excluded roots
+     *         are left out.
+     */
+    std::vector<uint32_t> resolve(const std::vector<uint32_t>& roots, bool suggests,
+                                  const std::function<void(uint32_t)>& discovered = nullptr) const;
+
+private:
+    const PackageDB& m_db;
+    std::vector<bool> m_excluded;
+};
+
+}
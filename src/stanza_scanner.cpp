@@ -0,0 +1,42 @@
+#include "stanza_scanner.h"
+
+#include "deb822.h"
+
+using namespace DEBAR;
+
+StanzaScanner::StanzaScanner(Callback callback)
+    : m_callback(callback)
+{
+}
+
+void StanzaScanner::write(const char *data, size_t size)
+{
+    m_buffer.append(data, size);
+
+    size_t begin = 0;
+    size_t pos = m_scanned;
+    while ((pos = Deb822Parser::find_end(m_buffer, pos)) != std::string::npos) {
+        emit(begin, pos + 1);
+        begin = pos + 2;
+        pos = begin;
+    }
+
+    m_buffer.erase(0, begin);
+    // The last byte may be the first newline of a separator.
+    m_scanned = m_buffer.empty() ? 0 : m_buffer.size() - 1;
+}
+
+void StanzaScanner::finish()
+{
+    emit(0, m_buffer.size());
+    m_buffer.clear();
+    m_scanned = 0;
+}
+
+void StanzaScanner::emit(size_t begin, size_t end)
+{
+    // Skip extra blank lines between stanzas.
+    while (begin < end && m_buffer[begin] == '\n') begin++;
+    if (begin == end) return;
+    m_callback(std::string_view(m_buffer.data() + begin, end - begin));
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief Splits a stream of Packages text into stanzas.
+ *
+ * Text is fed in arbitrary chunks, every complete stanza is passed to the
+ * callback.
+ */
+class StanzaScanner
+{
+public:
+    typedef std::function<void(std::string_view stanza)> Callback;
+
+    explicit StanzaScanner(Callback callback);
+
+    /**
+     * @brief Feed a chunk of text.
+     */
+    void write(const char* data, size_t size);
+
+    /**
+     * @brief Emit the last stanza if the text does not end with a blank line.
+     */
+    void finish();
+
+private:
+    void emit(size_t begin, size_t end);
+
+    Callback m_callback;
+    std::string m_buffer;
+    size_t m_scanned = 0;
+};
+
+}
@@ -1,22 +1,121 @@
 #pragma once
 
-#include <memory>
+#include <cstdint>
+#include <string_view>
 #include <vector>
-#include <string>
 
 namespace DEBAR {
 
-struct PackageInfo;
-typedef std::shared_ptr<PackageInfo> PackageInfoPtr;
-struct PackageInfo {
-    std::string name;
-    std::string version;
-    std::string description;
-    std::vector<PackageInfoPtr> depends;
-    std::vector<PackageInfoPtr> suggests;
-    std::string filename;
-    size_t size;
-    std::string md5;
+/**
+ * @brief A package of the database, the strings point into the mapped
+ *        database and stay valid until `--update` replaces it.
+ */
+struct PackageNode {
+    uint32_t id = 0;
+    std::string_view name;
+    std::string_view version;
+    std::string_view description;
+    std::string_view filename;
+    uint64_t size = 0;
+};
+
+/**
+ * @brief A resolved package graph.
+ *
+ * Nodes are stored contiguously and addressed by their position, the edges
+ * of all nodes share one array in CSR layout. The whole graph is freed at
+ * once and cycles need no special care.
+ */
+class PackageGraph {
+public:
+    /**
+     * @brief The positions of the nodes an edge list points to.
+     */
+    class EdgeList
+    {
+    public:
+        EdgeList(const uint32_t* begin, const uint32_t* end) : m_begin(begin), m_end(end) {}
+        const uint32_t* begin() const { return m_begin; }
+        const uint32_t* end() const { return m_end; }
+        size_t size() const { return m_end - m_begin; }
+    private:
+        const uint32_t* m_begin;
+        const uint32_t* m_end;
+    };
+
+    /**
+     * @brief Add a node, its edges are added before the next node.
+     * @param node The package.
+     * @return The position of the node.
+     */
+    uint32_t add(const PackageNode& node)
+    {
+        m_nodes.push_back(node);
+        m_offsets.push_back(m_edges.size());
+        m_offsets.push_back(m_edges.size());
+        return m_nodes.size() - 1;
+    }
+
+    /**
+     * @brief Add a Depends edge to the last node, before any Suggests edge.
+     * @param node The position of the dependency.
+     */
+    void add_depends(uint32_t node)
+    {
+        m_edges.push_back(node);
+        m_offsets.back()++;
+    }
+
+    /**
+     * @brief Add a Suggests edge to the last node.
+     * @param node The position of the suggested package.
+     */
+    void add_suggests(uint32_t node) { m_edges.push_back(node); }
+
+    /**
+     * @brief Mark a node as one of the packages the graph was resolved for.
+     * @param node The position of the node.
+     */
+    void add_root(uint32_t node) { m_roots.push_back(node); }
+
+    void reserve(size_t nodes)
+    {
+        m_nodes.reserve(nodes);
+        m_offsets.reserve(nodes * 2);
+    }
+
+    size_t size() const { return m_nodes.size(); }
+    bool empty() const { return m_nodes.empty(); }
+    const PackageNode& operator[](uint32_t node) const { return m_nodes[node]; }
+    std::vector<PackageNode>::const_iterator begin() const { return m_nodes.begin(); }
+    std::vector<PackageNode>::const_iterator end() const { return m_nodes.end(); }
+
+    /**
+     * @brief The positions of the packages the graph was resolved for.
+     */
+    const std::vector<uint32_t>& roots() const { return m_roots; }
+
+    /**
+     * @brief The first package the graph was resolved for.
+     */
+    const PackageNode& root() const { return m_nodes[m_roots.front()]; }
+
+    EdgeList depends(uint32_t node) const
+    {
+        return EdgeList(m_edges.data() + m_offsets[node * 2], m_edges.data() + m_offsets[node * 2 + 1]);
+    }
+
+    EdgeList suggests(uint32_t node) const
+    {
+        auto end = node * 2 + 2 < m_offsets.size() ? m_offsets[node * 2 + 2] : m_edges.size();
+        return EdgeList(m_edges.data() + m_offsets[node * 2 + 1], m_edges.data() + end);
+    }
+
+private:
+    std::vector<PackageNode> m_nodes;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_edges;
+    std::vector<uint32_t> m_roots;
 };
 
 }
@@ -0,0 +1,162 @@
+#include "trigram_index.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+
+#include "varint.h"
+
+using namespace DEBAR;
+
+namespace {
+
+const char TRIGRAM_MAGIC[4] = {'D', 'B', 'T', 'G'};
+const uint32_t TRIGRAM_VERSION = 1;
+
+struct TrigramHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t key_count;
+    uint64_t keys_offset;
+    uint64_t begin_offset;
+    uint64_t postings_offset;
+    uint64_t file_size;
+};
+
+uint32_t trigram_key(const char* p)
+{
+    return uint32_t(uint8_t(p[0])) << 16 | uint32_t(uint8_t(p[1])) << 8 | uint8_t(p[2]);
+}
+
+}
+
+void TrigramWriter::add(uint32_t id, std::string_view name)
+{
+    for (size_t i = 0; i + 3 <= name.size(); i++) {
+        auto& list = m_postings[trigram_key(name.data() + i)];
+        if (list.empty() || list.back() != id) list.push_back(id);
+    }
+}
+
+bool TrigramWriter::write(const std::string &path, uint32_t record_count) const
+{
+    std::vector<uint32_t> keys;
+    keys.reserve(m_postings.size());
+    for (const auto& it : m_postings) keys.push_back(it.first);
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t> begin;
+    std::string postings;
+    begin.reserve(keys.size() + 1);
+    for (auto key : keys) {
+        begin.push_back(postings.size());
+        uint32_t last = 0;
+        for (auto id : m_postings.at(key)) {
+            put_varint(postings, id - last);
+            last = id;
+        }
+    }
+    begin.push_back(postings.size());
+
+    TrigramHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRIGRAM_MAGIC, sizeof(header.magic));
+    header.version = TRIGRAM_VERSION;
+    header.record_count = record_count;
+    header.key_count = keys.size();
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    header.keys_offset = out.size();
+    out.append(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(uint32_t));
+    header.begin_offset = out.size();
+    out.append(reinterpret_cast<const char*>(begin.data()), begin.size() * sizeof(uint32_t));
+    header.postings_offset = out.size();
+    out.append(postings);
+    header.file_size = out.size();
+    memcpy(&out[0], &header, sizeof(header));
+
+    std::ofstream indexFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!indexFile) {
+        std::cerr << "Failed to create trigram index: " << path << std::endl;
+        return false;
+    }
+    indexFile.write(out.data(), out.size());
+    indexFile.flush();
+    return static_cast<bool>(indexFile);
+}
+
+bool TrigramIndex::open(const std::string &path)
+{
+    m_record_count = 0;
+    m_key_count = 0;
+    if (!m_file.open(path)) return false;
+
+    TrigramHeader header;
+    if (m_file.size() < sizeof(header)) {
+        m_file.close();
+        return false;
+    }
+    memcpy(&header, m_file.data(), sizeof(header));
+    if (memcmp(header.magic, TRIGRAM_MAGIC, sizeof(header.magic)) != 0
+        || header.version != TRIGRAM_VERSION
+        || header.file_size != m_file.size()) {
+        m_file.close();
+        return false;
+    }
+
+    const char* base = m_file.data();
+    m_record_count = header.record_count;
+    m_key_count = header.key_count;
+    m_keys = reinterpret_cast<const uint32_t*>(base + header.keys_offset);
+    m_begin = reinterpret_cast<const uint32_t*>(base + header.begin_offset);
+    m_postings = reinterpret_cast<const uint8_t*>(base + header.postings_offset);
+    return true;
+}
+
+std::vector<uint32_t> TrigramIndex::postings(uint32_t key) const
+{
+    std::vector<uint32_t> res;
+    auto it = std::lower_bound(m_keys, m_keys + m_key_count, key);
+    if (it == m_keys + m_key_count || *it != key) return res;
+
+    size_t i = it - m_keys;
+    const uint8_t* p = m_postings + m_begin[i];
+    const uint8_t* end = m_postings + m_begin[i + 1];
+    uint32_t id = 0;
+    while (p < end) {
+        id += static_cast<uint32_t>(get_varint(p));
+        res.push_back(id);
+    }
+    return res;
+}
+
+std::vector<uint32_t> TrigramIndex::candidates(std::string_view text) const
+{
+    if (!is_open() || text.size() < 3) return {};
+
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i + 3 <= text.size(); i++) keys.push_back(trigram_key(text.data() + i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // Start from the rarest trigram so the intersection shrinks quickly.
+    auto length = [this](uint32_t key) -> uint32_t {
+        auto it = std::lower_bound(m_keys, m_keys + m_key_count, key);
+        if (it == m_keys + m_key_count || *it != key) return 0;
+        size_t i = it - m_keys;
+        return m_begin[i + 1] - m_begin[i];
+    };
+    std::sort(keys.begin(), keys.end(), [&](uint32_t a, uint32_t b) { return length(a) < length(b); });
+
+    std::vector<uint32_t> res = postings(keys[0]);
+    for (size_t i = 1; i < keys.size() && !res.empty(); i++) {
+        auto other = postings(keys[i]);
+        std::vector<uint32_t> both;
+        std::set_intersection(res.begin(), res.end(), other.begin(), other.end(), std::back_inserter(both));
+        res.swap(both);
+    }
+    return res;
+}
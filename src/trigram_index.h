@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace DEBAR {
+
+/**
+ * @brief Builds the trigram index over package names written by `--update`.
+ *
+ * Every 3-byte substring of a name maps to the posting list of record
+ * ids containing it. Layout:
+ *  - header: magic, version, counts and offsets
+ *  - keys: sorted uint32 trigram keys
+ *  - begin: uint32 offsets into postings, one more than keys
+ *  - postings: delta encoded varint record ids, ascending
+ */
+class TrigramWriter
+{
+public:
+    /**
+     * @brief Add the trigrams of a record name, ids must be ascending.
+     * @param id The record id.
+     * @param name The name of package.
+     */
+    void add(uint32_t id, std::string_view name);
+
+    /**
+     * @brief Write the index to file.
+     * @param path The path of trigram index file.
+     * @param record_count Number of records in the package index.
+     * @return true if index written successfully.
+     */
+    bool write(const std::string& path, uint32_t record_count) const;
+
+private:
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+};
+
+/**
+ * @brief Read-only view of the trigram index, mapped once per process.
+ */
+class TrigramIndex
+{
+public:
+    /**
+     * @brief Map the trigram index file.
+     * @param path The path of trigram index file.
+     * @return true if index loaded successfully.
+     */
+    bool open(const std::string& path);
+
+    bool is_open() const { return m_file.is_open(); }
+
+    uint32_t record_count() const { return m_record_count; }
+
+    /**
+     * @brief Get the records whose name contains every trigram of a text.
+     *
+     * The result is a superset of the real matches, callers verify each
+     * candidate. Texts shorter than 3 bytes have no trigrams and cannot be
+     * answered by this index.
+     *
+     * @param text The text to search, at least 3 bytes.
+     * @return Candidate record ids, ascending.
+     */
+    std::vector<uint32_t> candidates(std::string_view text) const;
+
+private:
+    std::vector<uint32_t> postings(uint32_t key) const;
+
+    MappedFile m_file;
+    uint32_t m_record_count = 0;
+    uint32_t m_key_count = 0;
+    const uint32_t* m_keys = nullptr;
+    const uint32_t* m_begin = nullptr;
+    const uint8_t* m_postings = nullptr;
+};
+
+}
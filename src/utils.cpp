@@ -1,7 +1,15 @@
 #include "utils.h"
 
-#include <curl/curl.h>
+#include <fcntl.h>
+#include <filesystem>
 #include <iostream>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace fs = std::filesystem;
 
 std::string DEBAR::Utils::format_size(size_t size)
 {
@@ -17,67 +25,31 @@ std::string DEBAR::Utils::format_size(size_t size)
     return std::string(buffer);
 }
 
-std::vector<std::string> DEBAR::Utils::split_str(const std::string &str, const std::string &split)
+bool DEBAR::Utils::link_file(const std::string &from, const std::string &to)
 {
-    std::vector<std::string> result;
-    size_t start = 0;
-    size_t end = str.find(split);
-    while (end != std::string::npos) {
-        result.push_back(str.substr(start, end - start));
-        start = end + split.length();
-        end = str.find(split, start);
-    }
-    result.push_back(str.substr(start, end));
-    return result;
-}
+    std::error_code error;
+    fs::remove(to, error);
+    fs::create_hard_link(from, to, error);
+    if (!error) return true;
 
-int progress_callback(void* ptr, curl_off_t total_to_download, curl_off_t now_downloaded, curl_off_t total_to_upload, curl_off_t now_uploaded)
-{
-    if (total_to_download > 0) {
-        std::cout << (char*)ptr << " - " << (now_downloaded * 100 / total_to_download) << "% ("
-                  << DEBAR::Utils::format_size(now_downloaded) << " / " << DEBAR::Utils::format_size(total_to_download) << ") \r" << std::flush;
+#ifdef FICLONE
+    // Hard links do not cross file systems, a reflink still shares the blocks.
+    int in = open(from.c_str(), O_RDONLY);
+    if (in >= 0) {
+        int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool cloned = out >= 0 && ioctl(out, FICLONE, in) == 0;
+        if (out >= 0) close(out);
+        close(in);
+        if (cloned) return true;
+        fs::remove(to, error);
     }
-    return 0;
-}
-
-bool DEBAR::Utils::download_file(const std::string &url, const std::string &path, const char* prefix)
-{
-    CURL *curl;
-    FILE *fp;
-    CURLcode res;
-    char errorBuffer[CURL_ERROR_SIZE];
-    
-    curl = curl_easy_init();
-    if (curl) {
-        fp = fopen(path.c_str(), "wb");
-        if (!fp) {
-            std::cerr << "Failed to open file: " << path << std::endl;
-            return false;
-        }
-        struct curl_slist *headers = nullptr;
-        headers = curl_slist_append(headers, "User-Agent: Debian APT-HTTP/1.3 (1.0.1ubuntu2)");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-        curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
-        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L); // 启用自定义进度输出
-        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
-        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, prefix);
-        
-        res = curl_easy_perform(curl);
-        std::cout << std::endl;
-        if (res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << errorBuffer << std::endl;
-            fclose(fp);
-            curl_easy_cleanup(curl);
-            return false;
-        }
+#endif
 
-        fclose(fp);
-        curl_easy_cleanup(curl);
-        
-        return true;
+    error.clear();
+    fs::copy_file(from, to, fs::copy_options::overwrite_existing, error);
+    if (error) {
+        std::cerr << "Failed to copy " << from << " to " << to << ": " << error.message() << std::endl;
+        return false;
     }
-    return false;
+    return true;
 }
@@ -1,6 +1,5 @@
 #pragma once
 #include <string>
-#include <vector>
 
 namespace DEBAR {
 
@@ -11,14 +10,6 @@ namespace DEBAR {
 class Utils {
 
 public:
-    /**
-     * @brief Download file from url.
-     * @param url The url of file.
-     * @param path The path to save file.
-     * @return true if download file successfully.
-     */
-    static bool download_file(const std::string& url, const std::string& path, const char* prefix);
-
     /**
      * @brief Formats a given size in bytes into a human-readable string.
      * 
@@ -31,11 +22,16 @@ public:
     static std::string format_size(size_t size);
 
     /**
-     * @brief Split a string by a delimiter.
-     * @param str The string to be split.
-     * @param split The delimiter used to split the string.
-     * @return A vector of substrings obtained by splitting the input string.
+     * @brief Make a file appear at another path without copying it if possible.
+     *
+     * Tries a hard link first, then a reflink on file systems that support
+     * it, and copies the file as a last resort. An existing file at `to` is
+     * replaced.
+     *
+     * @param from The existing file.
+     * @param to The new path.
+     * @return true if the file is in place.
      */
-    static std::vector<std::string> split_str(const std::string& str, const std::string& split);
+    static bool link_file(const std::string& from, const std::string& to);
 };
 }
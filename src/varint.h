@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace DEBAR {
+
+/**
+ * @brief Append an unsigned LEB128 varint.
+ */
+inline void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Read an unsigned LEB128 varint and advance the pointer.
+ */
+inline uint64_t get_varint(const uint8_t*& p)
+{
+    uint64_t value = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        value |= uint64_t(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= uint64_t(*p++) << shift;
+    return value;
+}
+
+/**
+ * @brief Pad a buffer with zeros to a multiple of `align`.
+ */
+inline void pad_to(std::string& out, size_t align)
+{
+    while (out.size() % align) out.push_back('\0');
+}
+
+}
@@ -0,0 +1,28 @@
+#include "version.h"
+
+using namespace DEBAR;
+
+VersionOp DEBAR::parse_version_op(std::string_view op)
+{
+    if (op == "<<") return VersionOp::Less;
+    if (op == "<=" || op == "<") return VersionOp::LessEqual;
+    if (op == "=") return VersionOp::Equal;
+    if (op == ">=" || op == ">") return VersionOp::GreaterEqual;
+    if (op == ">>") return VersionOp::Greater;
+    return VersionOp::Any;
+}
+
+bool DEBAR::satisfies_version(std::string_view version, VersionOp op, std::string_view constraint)
+{
+    if (op == VersionOp::Any) return true;
+    int res = compare_versions(version, constraint);
+    switch (op) {
+    case VersionOp::Less: return res < 0;
+    case VersionOp::LessEqual: return res <= 0;
+    case VersionOp::Equal: return res == 0;
+    case VersionOp::GreaterEqual: return res >= 0;
+    case VersionOp::Greater: return res > 0;
+    case VersionOp::Any: break;
+    }
+    return true;
+}
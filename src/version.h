@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace DEBAR {
+
+/**
+ * @brief The operator of a version constraint in a relationship field.
+ */
+enum class VersionOp : uint8_t
+{
+    Any,
+    Less,
+    LessEqual,
+    Equal,
+    GreaterEqual,
+    Greater,
+};
+
+/**
+ * @brief Parse a version operator.
+ * @param op `<<`, `<=`, `=`, `>=`, `>>`, or the obsolete `<` and `>`
+ *           which mean `<=` and `>=`.
+ * @return The operator, Any if it is empty or unknown.
+ */
+VersionOp parse_version_op(std::string_view op);
+
+namespace version_detail {
+
+constexpr bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/**
+ * @brief The sort weight of a character in a non-digit run, 0 for the end.
+ */
+constexpr int order(std::string_view str, size_t i)
+{
+    if (i >= str.size()) return 0;
+    char c = str[i];
+    if (is_digit(c)) return 0;
+    if (is_alpha(c)) return c;
+    if (c == '~') return -1;
+    return static_cast<unsigned char>(c) + 256;
+}
+
+/**
+ * @brief dpkg's verrevcmp() over string views.
+ */
+constexpr int compare_part(std::string_view a, std::string_view b)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() || j < b.size()) {
+        while ((i < a.size() && !is_digit(a[i])) || (j < b.size() && !is_digit(b[j]))) {
+            int ac = order(a, i);
+            int bc = order(b, j);
+            if (ac != bc) return ac - bc;
+            i++;
+            j++;
+        }
+        while (i < a.size() && a[i] == '0') i++;
+        while (j < b.size() && b[j] == '0') j++;
+        int firstDiff = 0;
+        while (i < a.size() && j < b.size() && is_digit(a[i]) && is_digit(b[j])) {
+            if (!firstDiff) firstDiff = a[i] - b[j];
+            i++;
+            j++;
+        }
+        if (i < a.size() && is_digit(a[i])) return 1;
+        if (j < b.size() && is_digit(b[j])) return -1;
+        if (firstDiff) return firstDiff;
+    }
+    return 0;
+}
+
+struct Parts
+{
+    uint64_t epoch = 0;
+    std::string_view upstream;
+    std::string_view revision;
+};
+
+constexpr Parts split(std::string_view version)
+{
+    Parts parts;
+    auto colon = version.find(':');
+    if (colon != std::string_view::npos) {
+        for (size_t i = 0; i < colon && is_digit(version[i]); i++) parts.epoch = parts.epoch * 10 + (version[i] - '0');
+        version.remove_prefix(colon + 1);
+    }
+    auto hyphen = version.rfind('-');
+    parts.upstream = version.substr(0, hyphen);
+    if (hyphen != std::string_view::npos) parts.revision = version.substr(hyphen + 1);
+    return parts;
+}
+
+}
+
+/**
+ * @brief Compare two Debian versions the way dpkg does.
+ *
+ * Epochs compare numerically, upstream version and revision compare by
+ * alternating non-digit and digit runs, where `~` sorts before anything,
+ * even the end of the string. Nothing is allocated.
+ *
+ * @return Negative, zero or positive as a is older than, equal to or
+ *         newer than b.
+ */
+constexpr int compare_versions(std::string_view a, std::string_view b)
+{
+    auto pa = version_detail::split(a);
+    auto pb = version_detail::split(b);
+    if (pa.epoch != pb.epoch) return pa.epoch < pb.epoch ? -1 : 1;
+    int res = version_detail::compare_part(pa.upstream, pb.upstream);
+    if (res) return res;
+    return version_detail::compare_part(pa.revision, pb.revision);
+}
+
+/**
+ * @brief Check a version against a constraint.
+ * @param version The candidate version.
+ * @param op The operator, Any accepts every version.
+ * @param constraint The version after the operator.
+ */
+bool satisfies_version(std::string_view version, VersionOp op, std::string_view constraint);
+
+// Orderings checked against `dpkg --compare-versions`.
+static_assert(compare_versions("1.0~rc1", "1.0") < 0, "tilde sorts before the end");
+static_assert(compare_versions("1.0~~", "1.0~") < 0, "tilde sorts before the end");
+static_assert(compare_versions("1.0a", "1.0+") < 0, "letters sort before other characters");
+static_assert(compare_versions("1:0.1", "9.9") > 0, "epoch");
+static_assert(compare_versions("0:1.0", "1.0") == 0, "missing epoch is 0");
+static_assert(compare_versions("1.0", "1.0-0") == 0, "missing revision is 0");
+static_assert(compare_versions("2.31", "2.31-0ubuntu9") < 0, "missing revision");
+static_assert(compare_versions("1.2.3-1ubuntu1", "1.2.3-1") > 0, "revision");
+static_assert(compare_versions("1.10", "1.9") > 0, "digits compare numerically");
+static_assert(compare_versions("1.01", "1.1") == 0, "leading zeros");
+static_assert(compare_versions("1.0.1", "1.0") > 0, "trailing digits");
+static_assert(compare_versions("2.0", "2") > 0, "trailing digits");
+
+}